@@ -77,6 +77,8 @@ struct orbit_point *burningship_orbit(
 unsigned burningship_it(
 		unsigned maxit,
 		long double *cx, long double *cy,
+		const struct interior_check *ic,
+		struct orbit_resume *r,
 		long double *modulus)
 {
 	unsigned it = 1;
@@ -94,15 +96,36 @@ unsigned burningship_it(
 	x2 = x * x;
 	y2 = y * y;
 
+	if (r && r->it) {
+		x = r->x;
+		y = r->y;
+		x2 = x * x;
+		y2 = y * y;
+		it = r->it;
+		r->it = 0;
+	}
+
+	struct interior_state is;
+	interior_start(&is, ic, x, y);
+
 	while ((x2 + y2) < 4 && it++ < maxit) {
+		long double m2 = x2 + y2;
 		y = 2 * fabsl(x * y) - yc;
 		x = x2 - y2 - xc;
 		x2 = x * x;
 		y2 = y * y;
+		if (ic && (x2 + y2) < 4 && interior_caught(&is, x, y, m2))
+			return 0;
 	}
 
-	if (it >= maxit || it == 0)
+	if (it >= maxit || it == 0) {
+		if (r && it >= maxit) {
+			r->x = x;
+			r->y = y;
+			r->it = maxit;
+		}
 		return 0;
+	}
 
 	/* When using the renormalized formula for the escape radius,
 	 * a couple of additional iterations help reducing the size
@@ -121,3 +144,52 @@ unsigned burningship_it(
 
 	return it;
 }
+
+#if defined(GMANDEL_HAVE_FLOAT128)
+unsigned burningship_it_f128(
+		unsigned maxit,
+		gmandel_float128 *cx, gmandel_float128 *cy,
+		long double *modulus)
+{
+	unsigned it = 1;
+
+	gmandel_float128 x;
+	gmandel_float128 y;
+	gmandel_float128 xc;
+	gmandel_float128 yc;
+	gmandel_float128 x2;
+	gmandel_float128 y2;
+	gmandel_float128 xy;
+
+	x = xc = *cx;
+	y = yc = *cy;
+
+	x2 = x * x;
+	y2 = y * y;
+
+	while ((x2 + y2) < 4 && it++ < maxit) {
+		xy = x * y;
+		y = 2 * (xy < 0 ? -xy : xy) - yc;
+		x = x2 - y2 - xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (it >= maxit || it == 0)
+		return 0;
+
+	unsigned n = 2;
+	while (n--) {
+		xy = x * y;
+		y = 2 * (xy < 0 ? -xy : xy) - yc;
+		x = x2 - y2 - xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (modulus)
+		*modulus = sqrtl((long double)(x2 + y2));
+
+	return it;
+}
+#endif
@@ -42,6 +42,15 @@ struct orbit_point *burningship_orbit(
 unsigned burningship_it(
 		unsigned maxit,
 		long double *cx, long double *cy,
+		const struct interior_check *ic,
+		struct orbit_resume *r,
 		long double *modulus);
 
+#if defined(GMANDEL_HAVE_FLOAT128)
+unsigned burningship_it_f128(
+		unsigned maxit,
+		gmandel_float128 *cx, gmandel_float128 *cy,
+		long double *modulus);
+#endif
+
 #endif
@@ -0,0 +1,535 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#include "checkpoint.h"
+#include "fract.h"
+#include "mupoint.h"
+#include "xfuncs.h"
+
+/* Tiles are this many pixels a side, less at the right and bottom, which
+ * is how fract_compute() goes over the buffer too
+ */
+#define CHECKPOINT_TILE 32
+
+/* A record is its kind and the length of its payload as two uint32_t,
+ * the payload, and a crc32 of all that.
+ *
+ * RECORD_KEY: the renders the rest are of, as text, but for the top
+ *   edge of their view
+ * RECORD_TOP: the top edge of the render the records up to the next one
+ *   of these are of, as text. The bands of an image rendered a few rows
+ *   at a time are told apart by it.
+ * RECORD_TILE: the tile's column and row, and whether the render kept
+ *   all of its orbits there, as uint32_t, its mu in row order, and then
+ *   those orbits
+ * RECORD_DONE: whether the render kept its orbits as a uint32_t, and
+ *   then all of them
+ *
+ * Orbits are laid out as they are in fract_pending.
+ */
+enum {
+	RECORD_KEY = 1,
+	RECORD_TILE,
+	RECORD_DONE,
+	RECORD_TOP,
+};
+
+#define PENDING_SIZE (3 * sizeof(uint32_t) + 2 * sizeof(long double))
+
+static void mpfix_print(char *buf, size_t size, const struct mpfix *a)
+{
+	int n = snprintf(buf, size, " %d", a->neg);
+	for (unsigned k = 0; k <= MPFIX_LIMBS; k++)
+		n += snprintf(buf + n, size - n, "%08x", a->d[k]);
+}
+
+/* Everything but the top edge that goes into mu, and how the file is
+ * laid out
+ */
+static size_t key_print(const struct fract *f, char *buf, size_t size)
+{
+	int n = snprintf(buf, size,
+			"gmandel-checkpoint-3 %u %u %u %d %u %u %u "
+			"%La %La %La %d %u %d %d",
+			CHECKPOINT_TILE,
+			(unsigned)sizeof(gmandel_mu_t),
+			(unsigned)sizeof(long double),
+			f->type, f->width, f->height, f->maxit,
+			f->cx, f->cy, f->view.span,
+			f->subdivide, f->interior_checks,
+			f->distance_fill, f->colouring);
+	mpfix_print(buf + n, size - n, &f->view.ulx_mp);
+	return strlen(buf);
+}
+
+static void record_write(FILE *file, uint32_t kind,
+		const void *a, size_t alen, const void *b, size_t blen)
+{
+	uint32_t head[2] = { kind, alen + blen };
+	uLong crc = crc32(0, (const Bytef *)head, sizeof(head));
+	/* crc32() takes a NULL buffer as asking for its initial value */
+	if (alen)
+		crc = crc32(crc, a, alen);
+	if (blen)
+		crc = crc32(crc, b, blen);
+	uint32_t sum = crc;
+
+	fwrite(head, sizeof(head), 1, file);
+	fwrite(a, 1, alen, file);
+	fwrite(b, 1, blen, file);
+	fwrite(&sum, sizeof(sum), 1, file);
+}
+
+/* The payload of the next record, or NULL if it is cut short or does not
+ * add up. left is how much of the file there is from here on.
+ */
+static void *record_read(FILE *file, off_t left,
+		uint32_t *kind, uint32_t *len)
+{
+	uint32_t head[2];
+	uint32_t sum;
+
+	if (left < (off_t)(sizeof(head) + sizeof(sum))
+			|| fread(head, sizeof(head), 1, file) != 1)
+		return NULL;
+	if (head[1] > left - sizeof(head) - sizeof(sum))
+		return NULL;
+
+	void *p = xmalloc(head[1]);
+	if (fread(p, 1, head[1], file) != head[1]
+			|| fread(&sum, sizeof(sum), 1, file) != 1)
+		goto bad;
+
+	uLong crc = crc32(0, (const Bytef *)head, sizeof(head));
+	if (head[1])
+		crc = crc32(crc, p, head[1]);
+	if ((uint32_t)crc != sum)
+		goto bad;
+
+	*kind = head[0];
+	*len = head[1];
+	return p;
+
+bad:
+	free(p);
+	return NULL;
+}
+
+static unsigned char *pending_pack(const struct fract_pending *pending,
+		size_t n, unsigned char *p)
+{
+	for (size_t k = 0; k < n; k++) {
+		const struct fract_pending *e = &pending[k];
+		uint32_t u[3] = { e->i, e->j, e->r.it };
+		memcpy(p, u, sizeof(u));
+		p += sizeof(u);
+		memcpy(p, &e->r.x, sizeof(long double));
+		p += sizeof(long double);
+		memcpy(p, &e->r.y, sizeof(long double));
+		p += sizeof(long double);
+	}
+	return p;
+}
+
+static struct fract_pending *pending_unpack(const unsigned char *p,
+		size_t n)
+{
+	struct fract_pending *pending = xmalloc(n * sizeof(*pending));
+
+	for (size_t k = 0; k < n; k++) {
+		uint32_t u[3];
+		memcpy(u, p, sizeof(u));
+		p += sizeof(u);
+		pending[k].i = u[0];
+		pending[k].j = u[1];
+		pending[k].r.it = u[2];
+		memcpy(&pending[k].r.x, p, sizeof(long double));
+		p += sizeof(long double);
+		memcpy(&pending[k].r.y, p, sizeof(long double));
+		p += sizeof(long double);
+	}
+	return pending;
+}
+
+static void tile_rect(const struct fract *f, unsigned tx, unsigned ty,
+		unsigned *x0, unsigned *y0, unsigned *x1, unsigned *y1)
+{
+	*x0 = tx * CHECKPOINT_TILE;
+	*y0 = ty * CHECKPOINT_TILE;
+	*x1 = MIN(*x0 + CHECKPOINT_TILE, f->width);
+	*y1 = MIN(*y0 + CHECKPOINT_TILE, f->height);
+}
+
+static bool load_tile(struct checkpoint *c, struct fract *f,
+		const unsigned char *p, size_t len)
+{
+	uint32_t t[3];
+	if (len < sizeof(t))
+		return false;
+	memcpy(t, p, sizeof(t));
+	if (t[0] >= c->tiles_x || t[1] >= c->tiles_y)
+		return false;
+
+	unsigned x0, y0, x1, y1;
+	tile_rect(f, t[0], t[1], &x0, &y0, &x1, &y1);
+	size_t mlen = (x1 - x0) * (y1 - y0) * sizeof(gmandel_mu_t);
+	if (len < sizeof(t) + mlen
+			|| (len - sizeof(t) - mlen) % PENDING_SIZE
+			|| (!t[2] && len != sizeof(t) + mlen))
+		return false;
+
+	unsigned char *saved = &c->saved[t[1] * c->tiles_x + t[0]];
+	if (*saved)
+		return true;
+
+	/* the payload is not aligned for mu */
+	gmandel_mu_t *mu = xmalloc(mlen);
+	memcpy(mu, p + sizeof(t), mlen);
+	size_t n = (len - sizeof(t) - mlen) / PENDING_SIZE;
+	struct fract_pending *pending = pending_unpack(p + sizeof(t) + mlen, n);
+	fract_load_rect(f, x0, y0, x1, y1, mu, t[2] ? pending : NULL, n);
+	free(pending);
+	free(mu);
+
+	*saved = 1;
+	return true;
+}
+
+static bool all_saved(const struct checkpoint *c)
+{
+	for (size_t k = 0; k < (size_t)c->tiles_x * c->tiles_y; k++)
+		if (!c->saved[k])
+			return false;
+	return true;
+}
+
+static bool load_done(struct checkpoint *c, struct fract *f,
+		const unsigned char *p, size_t len)
+{
+	uint32_t kept;
+	if (len < sizeof(kept) || (len - sizeof(kept)) % PENDING_SIZE
+			|| !all_saved(c))
+		return false;
+
+	memcpy(&kept, p, sizeof(kept));
+	size_t n = (len - sizeof(kept)) / PENDING_SIZE;
+	struct fract_pending *pending = pending_unpack(p + sizeof(kept), n);
+
+	fract_load_pending(f, kept ? pending : NULL, n);
+	free(pending);
+
+	c->complete = true;
+	return true;
+}
+
+/* Loads the records after the key that are of top, skipping those of
+ * the other bands, and returns where the good ones end. last tells
+ * whether the last of them were of top.
+ */
+static off_t load_records(struct checkpoint *c, struct fract *f,
+		off_t size, const char *top, size_t tlen, bool *last)
+{
+	off_t good = ftello(c->file);
+	bool mine = false;
+
+	for (;;) {
+		uint32_t kind;
+		uint32_t len;
+		unsigned char *p = record_read(c->file, size - good, &kind, &len);
+		if (!p)
+			break;
+
+		bool ok = true;
+		if (kind == RECORD_TOP)
+			mine = len == tlen && memcmp(p, top, tlen) == 0;
+		else if (kind == RECORD_TILE && mine)
+			ok = load_tile(c, f, p, len);
+		else if (kind == RECORD_DONE && mine)
+			ok = load_done(c, f, p, len);
+		else if (kind != RECORD_TILE && kind != RECORD_DONE)
+			ok = false;
+		free(p);
+
+		if (!ok)
+			break;
+		good = ftello(c->file);
+	}
+
+	*last = mine;
+	return good;
+}
+
+bool checkpoint_open(struct checkpoint *c, const char *filename,
+		struct fract *f)
+{
+	FILE *file = fopen(filename, "r+b");
+	if (!file && errno == ENOENT)
+		file = fopen(filename, "w+b");
+	if (!file)
+		return false;
+
+	c->file = file;
+	c->tiles_x = DIV_ROUND_UP(f->width, CHECKPOINT_TILE);
+	c->tiles_y = DIV_ROUND_UP(f->height, CHECKPOINT_TILE);
+	size_t ntiles = (size_t)c->tiles_x * c->tiles_y;
+	c->saved = xmalloc(ntiles);
+	memset(c->saved, 0, ntiles);
+	c->tiles = xmalloc(ntiles * sizeof(*c->tiles));
+	for (size_t k = 0; k < ntiles; k++) {
+		c->tiles[k].p = NULL;
+		c->tiles[k].n = 0;
+		c->tiles[k].size = 0;
+		c->tiles[k].kept = true;
+		c->tiles[k].done = false;
+	}
+	c->complete = false;
+	c->last = time(NULL);
+	pthread_mutex_init(&c->lock, NULL);
+	pthread_mutex_init(&c->tiles_lock, NULL);
+
+	char key[1024];
+	size_t klen = key_print(f, key, sizeof(key));
+	char top[256];
+	mpfix_print(top, sizeof(top), &f->view.uly_mp);
+	size_t tlen = strlen(top);
+
+	struct stat st;
+	off_t good = 0;
+	bool last = false;
+	if (fstat(fileno(file), &st) == 0) {
+		uint32_t kind;
+		uint32_t len;
+		char *p = record_read(file, st.st_size, &kind, &len);
+		if (p && kind == RECORD_KEY && len == klen
+				&& memcmp(p, key, klen) == 0)
+			good = load_records(c, f, st.st_size, top, tlen, &last);
+		free(p);
+	}
+
+	/* whatever is past the good records was being written when the
+	 * last render died, and goes
+	 */
+	fflush(file);
+	if (ftruncate(fileno(file), good) != 0
+			|| fseeko(file, good, SEEK_SET) != 0) {
+		checkpoint_close(c);
+		return false;
+	}
+
+	/* what this render writes goes after a record saying which it is */
+	if (good == 0)
+		record_write(file, RECORD_KEY, key, klen, NULL, 0);
+	if (!last && !c->complete)
+		record_write(file, RECORD_TOP, top, tlen, NULL, 0);
+	fflush(file);
+	fsync(fileno(file));
+
+	return true;
+}
+
+void checkpoint_close(struct checkpoint *c)
+{
+	fclose(c->file);
+	c->file = NULL;
+	free(c->saved);
+	c->saved = NULL;
+	for (size_t k = 0; k < (size_t)c->tiles_x * c->tiles_y; k++)
+		free(c->tiles[k].p);
+	free(c->tiles);
+	c->tiles = NULL;
+	pthread_mutex_destroy(&c->lock);
+	pthread_mutex_destroy(&c->tiles_lock);
+}
+
+void checkpoint_tile(void *data,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		const struct fract_pending *p, size_t n, bool done)
+{
+	struct checkpoint *c = data;
+	unsigned tx = x0 / CHECKPOINT_TILE;
+	unsigned ty = y0 / CHECKPOINT_TILE;
+
+	/* anything else is left for checkpoint_finish() */
+	if (x0 % CHECKPOINT_TILE || y0 % CHECKPOINT_TILE
+			|| tx >= c->tiles_x || ty >= c->tiles_y
+			|| x1 - x0 > CHECKPOINT_TILE || y1 - y0 > CHECKPOINT_TILE
+			|| (x1 - x0 < CHECKPOINT_TILE && tx != c->tiles_x - 1)
+			|| (y1 - y0 < CHECKPOINT_TILE && ty != c->tiles_y - 1))
+		return;
+
+	size_t k = (size_t)ty * c->tiles_x + tx;
+	struct checkpoint_tile *t = &c->tiles[k];
+
+	pthread_mutex_lock(&c->tiles_lock);
+	if (!c->saved[k]) {
+		if (p) {
+			if (t->n + n > t->size) {
+				t->size = MAX(2 * t->size, t->n + n);
+				t->p = xrealloc(t->p, t->size * sizeof(*t->p));
+			}
+			memcpy(t->p + t->n, p, n * sizeof(*p));
+			t->n += n;
+		}
+		t->kept = t->kept && p;
+		t->done = done;
+	}
+	pthread_mutex_unlock(&c->tiles_lock);
+}
+
+static bool tile_finished(const struct fract *f,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+	for (unsigned j = y0; j < y1; j++)
+		for (unsigned i = x0; i < x1; i++)
+			if (MUPOINT_AT(&f->mupoint, i, j) < 0)
+				return false;
+	return true;
+}
+
+/* Called with the lock held. Writes the tiles f said are done, along with
+ * the orbits it kept there. Once f ran to the end, all is whatever has no
+ * pixel left negative, which is how pixels are marked to be done, and the
+ * orbits of tiles f did not say are done come with the last record.
+ */
+static bool save_tiles(struct checkpoint *c, const struct fract *f,
+		bool all)
+{
+	const struct mupoint *m = &f->mupoint;
+	size_t msize = CHECKPOINT_TILE * CHECKPOINT_TILE * sizeof(gmandel_mu_t);
+	unsigned char *buf = NULL;
+
+	for (unsigned ty = 0; ty < c->tiles_y; ty++)
+		for (unsigned tx = 0; tx < c->tiles_x; tx++) {
+			size_t k = (size_t)ty * c->tiles_x + tx;
+			unsigned x0, y0, x1, y1;
+			tile_rect(f, tx, ty, &x0, &y0, &x1, &y1);
+
+			/* f is done with the tile's pixels once it says so */
+			pthread_mutex_lock(&c->tiles_lock);
+			struct checkpoint_tile t = c->tiles[k];
+			bool ready = !c->saved[k] && (t.done || (all
+					&& tile_finished(f, x0, y0, x1, y1)));
+			if (ready) {
+				c->saved[k] = 1;
+				c->tiles[k].p = NULL;
+				c->tiles[k].n = 0;
+				c->tiles[k].size = 0;
+			}
+			pthread_mutex_unlock(&c->tiles_lock);
+			if (!ready)
+				continue;
+
+			uint32_t head[3] = { tx, ty, t.done && t.kept };
+			size_t n = head[2] ? t.n : 0;
+			buf = xrealloc(buf, msize + n * PENDING_SIZE);
+
+			/* the payload is not aligned for mu */
+			unsigned char *p = buf;
+			for (unsigned j = y0; j < y1; j++)
+				for (unsigned i = x0; i < x1; i++) {
+					gmandel_mu_t mu = MUPOINT_AT(m, i, j);
+					memcpy(p, &mu, sizeof(mu));
+					p += sizeof(mu);
+				}
+			p = pending_pack(t.p, n, p);
+			free(t.p);
+
+			record_write(c->file, RECORD_TILE, head, sizeof(head),
+					buf, p - buf);
+		}
+
+	free(buf);
+	c->last = time(NULL);
+
+	return fflush(c->file) == 0 && fsync(fileno(c->file)) == 0;
+}
+
+bool checkpoint_save(struct checkpoint *c, const struct fract *f)
+{
+	pthread_mutex_lock(&c->lock);
+	bool ok = save_tiles(c, f, false);
+	pthread_mutex_unlock(&c->lock);
+	return ok;
+}
+
+/* last is only looked at with the lock held, and threads that find it
+ * taken have nothing to do anyway
+ */
+void checkpoint_tick(struct checkpoint *c, const struct fract *f)
+{
+	if (pthread_mutex_trylock(&c->lock) != 0)
+		return;
+	if (time(NULL) - c->last >= CHECKPOINT_INTERVAL)
+		save_tiles(c, f, false);
+	pthread_mutex_unlock(&c->lock);
+}
+
+bool checkpoint_finish(struct checkpoint *c, const struct fract *f)
+{
+	if (c->complete)
+		return true;
+
+	pthread_mutex_lock(&c->lock);
+
+	bool ok = save_tiles(c, f, true);
+	if (!ok || !all_saved(c)) {
+		pthread_mutex_unlock(&c->lock);
+		return false;
+	}
+
+	uint32_t kept = f->pending.valid;
+	size_t n = kept ? f->pending.n : 0;
+	unsigned char *buf = xmalloc(n * PENDING_SIZE);
+	pending_pack(f->pending.p, n, buf);
+
+	record_write(c->file, RECORD_DONE, &kept, sizeof(kept),
+			buf, n * PENDING_SIZE);
+	free(buf);
+
+	ok = fflush(c->file) == 0 && fsync(fileno(c->file)) == 0;
+	c->complete = ok;
+
+	pthread_mutex_unlock(&c->lock);
+	return ok;
+}
@@ -0,0 +1,107 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_CHECKPOINT_H_
+#define GMANDEL_CHECKPOINT_H_ 1
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "fract.h"
+
+/* What the render told of a tile not saved yet: the orbits it kept
+ * there, whether it kept them all, and whether the tile is done
+ */
+struct checkpoint_tile {
+	struct fract_pending *p;
+	size_t n;
+	size_t size;
+	bool kept;
+	bool done;
+};
+
+/* A file a long render keeps appending its finished tiles to, with the
+ * orbits it kept in them for fract_continue(), so that rendering the
+ * same view again after a crash only computes the rest. Every record has
+ * its own checksum, and reading stops at the first one that is cut short
+ * or damaged, which is then written over. Once the render is done a last
+ * record says so. Renders differing only in their top edge, like the
+ * bands of an image done a few rows at a time, share a file. It is only
+ * good for the same build on the same kind of machine, anything else
+ * starts over.
+ */
+struct checkpoint {
+	FILE *file;
+	unsigned tiles_x;
+	unsigned tiles_y;
+	/* tiles the file already has, and what f told of the others, both
+	 * under tiles_lock
+	 */
+	unsigned char *saved;
+	struct checkpoint_tile *tiles;
+	pthread_mutex_t tiles_lock;
+	/* the file has the whole render, and f was loaded with it */
+	bool complete;
+	/* when tiles were last saved, under lock */
+	time_t last;
+	pthread_mutex_t lock;
+};
+
+/* f is set up for the render, with its size and view, and cleaned. What
+ * the file has of that render is loaded into it, and anything else in
+ * the file is thrown away. Returns false with errno set if the file
+ * could not be opened or created. f->tile is to be set to
+ * checkpoint_tile(), with c for its data, until c is closed.
+ */
+bool checkpoint_open(struct checkpoint *c, const char *filename,
+		struct fract *f);
+void checkpoint_close(struct checkpoint *c);
+
+void checkpoint_tile(void *data,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		const struct fract_pending *p, size_t n, bool done);
+
+/* Appends the tiles f finished since the last time and syncs the file.
+ * It can be called while f is being computed.
+ */
+bool checkpoint_save(struct checkpoint *c, const struct fract *f);
+/* The same every CHECKPOINT_INTERVAL seconds at most, for the progress
+ * callback. Threads finding another one saving go on with their work.
+ */
+void checkpoint_tick(struct checkpoint *c, const struct fract *f);
+/* Once f's render ran to the end */
+bool checkpoint_finish(struct checkpoint *c, const struct fract *f);
+
+#define CHECKPOINT_INTERVAL 30
+
+#endif
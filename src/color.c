@@ -41,6 +41,9 @@ static char *color_names[] = {
 	[COLOR_THEME_DEEPBLUE] = "deepblue",
 	[COLOR_THEME_VERYGREEN] = "verygreen",
 	[COLOR_THEME_DARKGREY] = "darkgrey",
+	[COLOR_THEME_SUNSET] = "sunset",
+	[COLOR_THEME_OCEAN] = "ocean",
+	[COLOR_THEME_ELECTRIC] = "electric",
 	[COLOR_THEME_LAST] = NULL,
 };
 
@@ -52,6 +55,41 @@ static const struct color_ratios color_ratios[] = {
 	[COLOR_THEME_DEEPBLUE] = { .red = 0.1, .blue = 1, .green = 0.3 },
 	[COLOR_THEME_VERYGREEN] = { .red = 0.01, .blue = 0.01, .green = 0.3 },
 	[COLOR_THEME_DARKGREY] = { .red = 0.3, .blue = 0.3, .green = 0.3 },
+	[COLOR_THEME_SUNSET] = { .red = 1, .blue = 0.2, .green = 0.5 },
+	[COLOR_THEME_OCEAN] = { .red = 0.3, .blue = 1, .green = 0.7 },
+	[COLOR_THEME_ELECTRIC] = { .red = 0.5, .blue = 1, .green = 0.6 },
+};
+
+static const struct color_stop sunset[] = {
+	{ 0, 0, 0, 0 },
+	{ 0.15, 80, 0, 60 },
+	{ 0.35, 200, 40, 40 },
+	{ 0.6, 255, 150, 0 },
+	{ 1, 255, 255, 200 },
+};
+
+static const struct color_stop ocean[] = {
+	{ 0, 0, 0, 0 },
+	{ 0.2, 0, 30, 90 },
+	{ 0.5, 0, 130, 180 },
+	{ 0.8, 120, 220, 230 },
+	{ 1, 255, 255, 255 },
+};
+
+static const struct color_stop electric[] = {
+	{ 0, 0, 0, 0 },
+	{ 0.1, 20, 0, 120 },
+	{ 0.3, 130, 0, 255 },
+	{ 0.6, 0, 200, 255 },
+	{ 1, 255, 255, 255 },
+};
+
+#define GRADIENT(s) { .n = sizeof(s) / sizeof(s[0]), .stops = s }
+
+static const struct color_gradient color_gradients[] = {
+	[COLOR_THEME_SUNSET] = GRADIENT(sunset),
+	[COLOR_THEME_OCEAN] = GRADIENT(ocean),
+	[COLOR_THEME_ELECTRIC] = GRADIENT(electric),
 };
 
 char **color_get_names(void)
@@ -66,3 +104,36 @@ const struct color_ratios *color_get(enum COLOR_THEMES c)
 	else
 		return NULL;
 }
+
+const struct color_gradient *color_get_gradient(enum COLOR_THEMES c)
+{
+	if (c >= 0 && c < COLOR_THEME_LAST && color_gradients[c].n > 0)
+		return &color_gradients[c];
+	else
+		return NULL;
+}
+
+/* Linear between the stops around t, clamped to the ends */
+void color_gradient_at(const struct color_gradient *g, float t,
+		unsigned char rgb[3])
+{
+	const struct color_stop *a = &g->stops[0];
+	const struct color_stop *b = &g->stops[g->n - 1];
+
+	if (t <= a->pos)
+		b = a;
+	else if (t >= b->pos)
+		a = b;
+	else
+		for (unsigned k = 1; k < g->n; k++)
+			if (t < g->stops[k].pos) {
+				a = &g->stops[k - 1];
+				b = &g->stops[k];
+				break;
+			}
+
+	float w = b->pos > a->pos ? (t - a->pos) / (b->pos - a->pos) : 0;
+	rgb[0] = a->red + w * (b->red - a->red) + 0.5f;
+	rgb[1] = a->green + w * (b->green - a->green) + 0.5f;
+	rgb[2] = a->blue + w * (b->blue - a->blue) + 0.5f;
+}
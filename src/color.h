@@ -40,6 +40,9 @@ enum COLOR_THEMES {
 	COLOR_THEME_DEEPBLUE,
 	COLOR_THEME_VERYGREEN,
 	COLOR_THEME_DARKGREY,
+	COLOR_THEME_SUNSET,
+	COLOR_THEME_OCEAN,
+	COLOR_THEME_ELECTRIC,
 	COLOR_THEME_LAST,
 };
 
@@ -49,7 +52,26 @@ struct color_ratios {
 	float green;
 };
 
+/* Themes going through several colours instead of scaling each channel
+ * have a gradient, stops being sorted by pos from 0 to 1. Their ratios
+ * are only a rough match for code that doesn't know about gradients.
+ */
+struct color_stop {
+	float pos;
+	unsigned char red;
+	unsigned char green;
+	unsigned char blue;
+};
+
+struct color_gradient {
+	unsigned n;
+	const struct color_stop *stops;
+};
+
 char **color_get_names(void);
 const struct color_ratios *color_get(enum COLOR_THEMES c);
+const struct color_gradient *color_get_gradient(enum COLOR_THEMES c);
+void color_gradient_at(const struct color_gradient *g, float t,
+		unsigned char rgb[3]);
 
 #endif
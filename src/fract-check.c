@@ -0,0 +1,596 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <float.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "fract.h"
+#include "mpfix.h"
+#include "mupoint.h"
+#include "xfuncs.h"
+
+/* Renders a few views with each shortcut the renderer takes and checks
+ * them against a plain render, one pixel at a time with every option
+ * off, views past long double against exact arithmetic and views on
+ * either side of each precision boundary against long double. Run by
+ * make check.
+ */
+
+#define WIDTH 320
+#define HEIGHT 240
+
+struct view {
+	const char *name;
+	enum fract_type type;
+	double ulx;
+	double uly;
+	double lly;
+	unsigned maxit;
+	long double cx;
+	long double cy;
+	/* Subdivision and distance fill blend what they fill from its
+	 * border, which is off from the pixels inside by this much at most
+	 * on the view. Anything else must match exactly.
+	 */
+	double subdivide_tolerance;
+	double fill_tolerance;
+};
+
+static const struct view views[] = {
+	{ "mandelbrot", FRACT_MANDELBROT, -2.1, 1.1, -1.1, 500,
+		0, 0, 5e-4, 3e-5 },
+	{ "seahorses", FRACT_MANDELBROT, -0.76, 0.13, 0.06, 2000,
+		0, 0, 0, 0 },
+	{ "julia", FRACT_JULIA, -1.6, 1.2, -1.2, 500,
+		-0.8L, 0.156L, 1.3e-3, 1.5e-4 },
+	{ "burningship", FRACT_BURNINGSHIP, -2.0, 1.5, -1.5, 500,
+		0, 0, 0, 0 },
+};
+
+/* Views too deep for any native type, on the Misiurewicz point i, which
+ * is on the boundary however close one looks
+ */
+struct deep_view {
+	const char *name;
+	long double span;
+	unsigned maxit;
+};
+
+static const struct deep_view deep_views[] = {
+	{ "deep", 1e-20L, 2000 },
+	{ "deeper", 1e-100L, 2000 },
+};
+
+/* Deep views are iterated with struct mpfix pixel by pixel, so they
+ * are kept small
+ */
+#define DEEP_WIDTH 64
+#define DEEP_HEIGHT 48
+
+/* Views on the boundary between two of the types fract_begin() picks
+ * from, either side of where pixels are 2 * 1024 ulps of the type apart
+ * (PRECISION_MARGIN in fract.c)
+ */
+struct tier_view {
+	const char *name;
+	enum fract_type type;
+	long double x;
+	long double y;
+	long double epsilon;
+	enum fract_precision coarser;
+	enum fract_precision finer;
+};
+
+#define TIER_ULPS (2 * 1024)
+
+static const struct tier_view tier_views[] = {
+	{ "float tier", FRACT_MANDELBROT, 0, 1, FLT_EPSILON,
+		FRACT_PRECISION_FLOAT, FRACT_PRECISION_DOUBLE },
+	{ "double tier", FRACT_MANDELBROT, 0, 1, DBL_EPSILON,
+		FRACT_PRECISION_DOUBLE, FRACT_PRECISION_LONG_DOUBLE },
+	/* a Misiurewicz point, the real part of c is negated there */
+	{ "long double tier", FRACT_BURNINGSHIP,
+		1.5436890126920764L, 0, LDBL_EPSILON,
+		FRACT_PRECISION_LONG_DOUBLE,
+#if defined(GMANDEL_HAVE_FLOAT128)
+		FRACT_PRECISION_FLOAT128
+#else
+		FRACT_PRECISION_LONG_DOUBLE
+#endif
+	},
+};
+
+static unsigned failures;
+
+/* A fract for v with every option off, whatever the defaults are */
+static void setup(struct fract *f, const struct view *v)
+{
+	fract_init(f, v->type, 0);
+	fract_set_size(f, WIDTH, HEIGHT);
+	fract_view_from_limits(&f->view, v->ulx, v->uly, v->lly);
+	f->maxit = v->maxit;
+	f->cx = v->cx;
+	f->cy = v->cy;
+	f->subdivide = false;
+	f->interior_checks = 0;
+	f->coarse = 1;
+	f->resume = false;
+	f->distance_fill = false;
+	f->colouring = FRACT_COLOUR_ITERATIONS;
+}
+
+static void render(struct fract *f)
+{
+	fract_clean(f);
+	fract_begin(f);
+	fract_compute(f);
+}
+
+static gmandel_mu_t *copy_mu(const struct fract *f)
+{
+	gmandel_mu_t *mu = xmalloc(f->width * f->height * sizeof(*mu));
+	for (unsigned j = 0; j < f->height; j++)
+		for (unsigned i = 0; i < f->width; i++)
+			mu[j * f->width + i] = MUPOINT_AT(&f->mupoint, i, j);
+	return mu;
+}
+
+static void compare(const char *view, const char *what,
+		const struct fract *f, const gmandel_mu_t *ref,
+		double tolerance)
+{
+	unsigned differ = 0;
+	double worst = 0;
+
+	for (unsigned j = 0; j < f->height; j++)
+		for (unsigned i = 0; i < f->width; i++) {
+			double d = fabs((double)MUPOINT_AT(&f->mupoint, i, j)
+					- ref[j * f->width + i]);
+			if (d > 0)
+				differ++;
+			worst = MAX(worst, d);
+		}
+
+	bool ok = worst <= tolerance;
+	printf("%-4s %s: %s, %u pixels differ, by up to %g\n",
+			ok ? "ok" : "FAIL", view, what, differ, worst);
+	if (!ok)
+		failures++;
+}
+
+/* Renders from, then to with fract_zoom(), and checks that against a
+ * fresh render of to. Distances must never be carried over. Escape counts
+ * are unless to needs more precision than from was rendered at.
+ */
+static void check_zoom(const struct view *v, enum fract_colouring colouring,
+		const char *what, const struct fract_view *from,
+		const struct fract_view *to)
+{
+	struct fract f;
+
+	setup(&f, v);
+	f.colouring = colouring;
+	f.view = *to;
+	render(&f);
+	gmandel_mu_t *ref = copy_mu(&f);
+	fract_destroy(&f);
+
+	setup(&f, v);
+	f.colouring = colouring;
+	f.view = *from;
+	render(&f);
+	f.view = *to;
+	bool carried = fract_zoom(&f);
+	if (carried && colouring != FRACT_COLOUR_ITERATIONS) {
+		printf("FAIL %s: %s, fract_zoom() carried pixels over\n",
+				v->name, what);
+		failures++;
+	} else {
+		if (!carried)
+			fract_clean(&f);
+		fract_begin(&f);
+		fract_compute(&f);
+		char buf[64];
+		snprintf(buf, sizeof(buf), "%s, %s", what,
+				carried ? "carried over" : "afresh");
+		compare(v->name, buf, &f, ref, 0);
+	}
+	fract_destroy(&f);
+
+	free(ref);
+}
+
+#define CHECKPOINT_FILE "fract-check.checkpoint"
+
+struct crash {
+	struct checkpoint *c;
+	struct fract *f;
+	unsigned ticks;
+};
+
+/* Saves half way through and dies, as far as the checkpoint can tell */
+static void crash_tick(void *data)
+{
+	struct crash *t = data;
+	if (--t->ticks == 0) {
+		checkpoint_save(t->c, t->f);
+		fract_stop(t->f);
+	}
+}
+
+/* Renders at a quarter of the iterations with a checkpoint, crashing
+ * half way through the last pass over the buffer's tiles, 32 pixels a
+ * side, picks it up from the file and carries on with all the
+ * iterations, which has to come out as a plain render of those
+ */
+static void check_checkpoint(const struct view *v, const gmandel_mu_t *ref)
+{
+	struct fract f;
+	struct checkpoint c;
+
+	unlink(CHECKPOINT_FILE);
+	setup(&f, v);
+	f.resume = true;
+	f.coarse = 8;
+	f.maxit = v->maxit / 4;
+	fract_clean(&f);
+	if (!checkpoint_open(&c, CHECKPOINT_FILE, &f)) {
+		perror(CHECKPOINT_FILE);
+		exit(EXIT_FAILURE);
+	}
+	unsigned tiles = DIV_ROUND_UP(WIDTH, 32) * DIV_ROUND_UP(HEIGHT, 32);
+	struct crash t = { &c, &f, fract_ticks(&f) - tiles / 2 };
+	f.progress = crash_tick;
+	f.progress_data = &t;
+	f.tile = checkpoint_tile;
+	f.tile_data = &c;
+	fract_begin(&f);
+	fract_compute(&f);
+	checkpoint_close(&c);
+	fract_destroy(&f);
+
+	setup(&f, v);
+	f.resume = true;
+	f.coarse = 8;
+	f.maxit = v->maxit / 4;
+	fract_clean(&f);
+	if (!checkpoint_open(&c, CHECKPOINT_FILE, &f)) {
+		perror(CHECKPOINT_FILE);
+		exit(EXIT_FAILURE);
+	}
+	f.tile = checkpoint_tile;
+	f.tile_data = &c;
+	bool partial = f.pending.partial;
+	fract_begin(&f);
+	fract_compute(&f);
+	checkpoint_finish(&c, &f);
+	checkpoint_close(&c);
+	f.tile = NULL;
+	unlink(CHECKPOINT_FILE);
+
+	f.maxit = v->maxit;
+	if (partial || !fract_continue(&f)) {
+		printf("FAIL %s: checkpoint lost the orbits\n", v->name);
+		failures++;
+	} else {
+		fract_begin(&f);
+		fract_compute(&f);
+		compare(v->name, "checkpoint", &f, ref, 0);
+	}
+	fract_destroy(&f);
+}
+
+static void check_view(const struct view *v)
+{
+	struct fract f;
+
+	setup(&f, v);
+	render(&f);
+	gmandel_mu_t *ref = copy_mu(&f);
+	fract_destroy(&f);
+
+	setup(&f, v);
+	f.subdivide = true;
+	render(&f);
+	compare(v->name, "subdivision", &f, ref, v->subdivide_tolerance);
+	fract_destroy(&f);
+
+	setup(&f, v);
+	f.interior_checks = FRACT_INTERIOR_PERIODICITY;
+	render(&f);
+	compare(v->name, "periodicity checks", &f, ref, 0);
+	fract_destroy(&f);
+
+	setup(&f, v);
+	f.interior_checks = FRACT_INTERIOR_DERIVATIVE;
+	render(&f);
+	compare(v->name, "derivative checks", &f, ref, 0);
+	fract_destroy(&f);
+
+	setup(&f, v);
+	f.coarse = 8;
+	render(&f);
+	compare(v->name, "coarse passes", &f, ref, 0);
+	fract_destroy(&f);
+
+	if (v->type != FRACT_BURNINGSHIP) {
+		setup(&f, v);
+		f.distance_fill = true;
+		render(&f);
+		compare(v->name, "distance fill", &f, ref, v->fill_tolerance);
+		fract_destroy(&f);
+	}
+
+	/* the same view with a quarter of the iterations first */
+	setup(&f, v);
+	f.resume = true;
+	f.maxit = v->maxit / 4;
+	render(&f);
+	f.maxit = v->maxit;
+	if (fract_continue(&f)) {
+		fract_begin(&f);
+		fract_compute(&f);
+		compare(v->name, "fract_continue()", &f, ref, 0);
+	} else {
+		printf("FAIL %s: fract_continue() refused\n", v->name);
+		failures++;
+	}
+	fract_destroy(&f);
+
+	check_checkpoint(v, ref);
+
+	free(ref);
+
+	/* twice as close on the middle of the view, and back out */
+	struct fract_view whole, middle;
+	setup(&f, v);
+	whole = f.view;
+	fract_view_zoom(&f, WIDTH / 4, HEIGHT / 4, 2, &middle);
+	fract_destroy(&f);
+
+	check_zoom(v, FRACT_COLOUR_ITERATIONS, "zoom in", &whole, &middle);
+	check_zoom(v, FRACT_COLOUR_ITERATIONS, "zoom out", &middle, &whole);
+	if (v->type != FRACT_BURNINGSHIP) {
+		check_zoom(v, FRACT_COLOUR_DISTANCE, "zoom in by distance",
+				&whole, &middle);
+		check_zoom(v, FRACT_COLOUR_DISTANCE, "zoom out by distance",
+				&middle, &whole);
+	}
+}
+
+/* The view span wide and centred on (x, y) */
+static void view_around(struct fract *f, long double x, long double y,
+		long double span)
+{
+	long double inc = span / (f->height - 1);
+	struct fract_view *v = &f->view;
+
+	v->ulx = x - (f->width - 1) / 2.0L * inc;
+	v->uly = y + span / 2;
+	v->lly = y - span / 2;
+	mpfix_from_long_double(&v->ulx_mp, x);
+	mpfix_add_long_double(&v->ulx_mp, -((f->width - 1) / 2.0L * inc));
+	mpfix_from_long_double(&v->uly_mp, y);
+	mpfix_add_long_double(&v->uly_mp, span / 2);
+	v->span = span;
+}
+
+static void setup_deep(struct fract *f, const struct deep_view *v)
+{
+	const struct view flat = {
+		.type = FRACT_MANDELBROT,
+		.maxit = v->maxit,
+	};
+
+	setup(f, &flat);
+	fract_set_size(f, DEEP_WIDTH, DEEP_HEIGHT);
+	view_around(f, 0, 1, v->span);
+}
+
+/* What mandelbrot_it() would say about pixel (i, j) with exact
+ * arithmetic. The extra iterations after escaping are done in long
+ * double, as perturb_it() does them.
+ */
+static gmandel_mu_t exact_mu(const struct fract *f, unsigned i, unsigned j)
+{
+	long double inc = fract_inc(f);
+	struct mpfix xc = f->view.ulx_mp;
+	struct mpfix yc = f->view.uly_mp;
+	struct mpfix x, y, x2, y2, t;
+	long double lx, ly;
+	unsigned it = 1;
+
+	mpfix_add_long_double(&xc, i * inc);
+	mpfix_add_long_double(&yc, -(j * inc));
+	x = xc;
+	y = yc;
+
+	for (;;) {
+		lx = mpfix_to_long_double(&x);
+		ly = mpfix_to_long_double(&y);
+		if (lx * lx + ly * ly >= 4)
+			break;
+		if (it++ >= f->maxit)
+			return 0;
+		mpfix_mul(&x2, &x, &x);
+		mpfix_mul(&y2, &y, &y);
+		mpfix_mul(&t, &x, &y);
+		mpfix_add(&t, &t, &t);
+		mpfix_add(&y, &t, &yc);
+		mpfix_sub(&t, &x2, &y2);
+		mpfix_add(&x, &t, &xc);
+	}
+
+	long double cx = mpfix_to_long_double(&xc);
+	long double cy = mpfix_to_long_double(&yc);
+	for (unsigned n = 0; n < 2; n++) {
+		long double nx = lx * lx - ly * ly + cx;
+		ly = 2 * lx * ly + cy;
+		lx = nx;
+	}
+
+	long double mu = (it - logl(fabsl(logl(hypotl(lx, ly))))) / M_LN2;
+	return mu < 0 ? 0 : mu;
+}
+
+/* Perturbation needs several references on these views, every one but
+ * the first for pixels the ones before glitched on. With only one, the
+ * pixels it glitches on must come out as a long double render has them.
+ */
+static void check_deep(const struct deep_view *v)
+{
+	struct fract f;
+	struct fract g;
+
+	setup_deep(&f, v);
+	render(&f);
+	if (f.precision != FRACT_PRECISION_PERTURBATION) {
+		printf("FAIL %s: not rendered with perturbation\n", v->name);
+		failures++;
+	}
+
+	gmandel_mu_t *ref = xmalloc(DEEP_WIDTH * DEEP_HEIGHT * sizeof(*ref));
+	for (unsigned j = 0; j < DEEP_HEIGHT; j++)
+		for (unsigned i = 0; i < DEEP_WIDTH; i++)
+			ref[j * DEEP_WIDTH + i] = exact_mu(&f, i, j);
+	/* they only differ in how the last iterations were rounded */
+	compare(v->name, "perturbation", &f, ref, 1e-4);
+	free(ref);
+
+	ref = copy_mu(&f);
+	fract_destroy(&f);
+
+	setup_deep(&g, v);
+	fract_clean(&g);
+	fract_begin(&g);
+	g.precision = FRACT_PRECISION_LONG_DOUBLE;
+	fract_compute(&g);
+
+	setup_deep(&f, v);
+	f.references = 1;
+	render(&f);
+
+	unsigned fallen = 0;
+	unsigned neither = 0;
+	for (unsigned j = 0; j < DEEP_HEIGHT; j++)
+		for (unsigned i = 0; i < DEEP_WIDTH; i++) {
+			gmandel_mu_t mu = MUPOINT_AT(&f.mupoint, i, j);
+			if (mu == ref[j * DEEP_WIDTH + i])
+				continue;
+			if (mu == MUPOINT_AT(&g.mupoint, i, j))
+				fallen++;
+			else
+				neither++;
+		}
+
+	bool ok = fallen && !neither;
+	printf("%-4s %s: long double fallback, %u pixels fell back, "
+			"%u match neither render\n",
+			ok ? "ok" : "FAIL", v->name, fallen, neither);
+	if (!ok)
+		failures++;
+
+	fract_destroy(&f);
+	fract_destroy(&g);
+	free(ref);
+}
+
+/* On either side of the boundary fract_begin() must pick the type for
+ * that side, and the render must agree with a long double one but for
+ * one pixel in a thousand more than an iteration off.
+ */
+static void check_tier(const struct tier_view *v, long double k,
+		enum fract_precision expected)
+{
+	const struct view flat = {
+		.type = v->type,
+		.maxit = 1000,
+	};
+	long double span = k * v->epsilon * TIER_ULPS * (HEIGHT - 1);
+	struct fract f;
+	struct fract g;
+
+	setup(&f, &flat);
+	view_around(&f, v->x, v->y, span);
+	fract_clean(&f);
+	fract_begin(&f);
+	if (f.precision != expected) {
+		printf("FAIL %s: %Lg tall, picked %u instead of %u\n",
+				v->name, span, f.precision, expected);
+		failures++;
+	}
+	fract_compute(&f);
+
+	setup(&g, &flat);
+	view_around(&g, v->x, v->y, span);
+	fract_clean(&g);
+	fract_begin(&g);
+	g.precision = FRACT_PRECISION_LONG_DOUBLE;
+	fract_compute(&g);
+
+	unsigned off = 0;
+	for (unsigned j = 0; j < HEIGHT; j++)
+		for (unsigned i = 0; i < WIDTH; i++)
+			if (fabsl(MUPOINT_AT(&f.mupoint, i, j)
+					- MUPOINT_AT(&g.mupoint, i, j)) > 1)
+				off++;
+
+	bool ok = off <= WIDTH * HEIGHT / 1000;
+	printf("%-4s %s: %Lg tall, %u pixels more than an iteration off\n",
+			ok ? "ok" : "FAIL", v->name, span, off);
+	if (!ok)
+		failures++;
+
+	fract_destroy(&f);
+	fract_destroy(&g);
+}
+
+int main(void)
+{
+	for (unsigned k = 0; k < sizeof(views) / sizeof(views[0]); k++)
+		check_view(&views[k]);
+	for (unsigned k = 0;
+			k < sizeof(deep_views) / sizeof(deep_views[0]); k++)
+		check_deep(&deep_views[k]);
+	for (unsigned k = 0;
+			k < sizeof(tier_views) / sizeof(tier_views[0]); k++) {
+		check_tier(&tier_views[k], 1.5L, tier_views[k].coarser);
+		check_tier(&tier_views[k], 1 / 1.5L, tier_views[k].finer);
+	}
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
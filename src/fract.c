@@ -0,0 +1,1964 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mandelbrot.h"
+#include "julia.h"
+#include "burningship.h"
+#include "simd.h"
+#include "color.h"
+#include "color_filter.h"
+#include "mpfix.h"
+#include "mupoint.h"
+#include "perturb.h"
+#include "tilepool.h"
+#include "xfuncs.h"
+#include "fract.h"
+#include "gfract_engines.h"
+
+#define LIMITS_ULX_DEFAULT (-2.1)
+#define LIMITS_ULY_DEFAULT (1.1)
+#define LIMITS_LLY_DEFAULT (-1.1)
+
+#define TILE_SIZE 32
+
+/* Entries in the colour table fract_colour() maps mu through */
+#define COLOUR_LUT_SIZE 4096
+
+/* Gradients span the values of mu times the energy factor over which a
+ * channel with a ratio of 1 goes from black to saturation.
+ */
+#define GRADIENT_SPAN 65535.0f
+
+/* How far from a whole zoom factor, relatively, and from a whole pixel
+ * offset, in pixels, views fract_zoom() carries pixels between can be
+ */
+#define ZOOM_EPS 1e-9L
+
+/* Equal width bins between the smallest and largest mu on screen that
+ * equalised colouring ranks pixels with
+ */
+#define HISTOGRAM_BINS 65536
+
+static void limits_round(struct fract_view *o)
+{
+	o->ulx = mpfix_to_long_double(&o->ulx_mp);
+	o->uly = mpfix_to_long_double(&o->uly_mp);
+	o->lly = mpfix_to_long_double(&o->uly_mp) - o->span;
+}
+
+void fract_view_from_limits(struct fract_view *o,
+		double ulx, double uly, double lly)
+{
+	o->ulx = ulx;
+	o->uly = uly;
+	o->lly = lly;
+	mpfix_from_long_double(&o->ulx_mp, ulx);
+	mpfix_from_long_double(&o->uly_mp, uly);
+	o->span = (long double)uly - lly;
+}
+
+long double fract_inc(const struct fract *f)
+{
+	return f->view.span / (f->height - 1);
+}
+
+/* Worked out on the exact view so that zooming in keeps going past the
+ * precision of the doubles.
+ */
+void fract_view_box(const struct fract *f,
+		unsigned sx, unsigned sy, unsigned dx, unsigned dy,
+		struct fract_view *o)
+{
+	unsigned n_height = MAX(sy, dy) - MIN(sy, dy);
+	unsigned n_width = f->width * n_height / f->height;
+	if (dx < sx)
+		n_width = -n_width;
+
+	/* sx, sy, dx and dy are measured in pixels. thats why this
+	 * check is _so_ anti-intuitive
+	 */
+	unsigned nuy = MIN(sy, dy);
+	unsigned nly = MAX(sy, dy);
+	unsigned nux = MIN(sx + n_width, sx);
+
+	long double inc = fract_inc(f);
+	*o = f->view;
+	mpfix_add_long_double(&o->ulx_mp, nux * inc);
+	mpfix_add_long_double(&o->uly_mp, -(nuy * inc));
+	o->span = (nly - nuy) * inc;
+	limits_round(o);
+}
+
+void fract_view_zoom(const struct fract *f,
+		unsigned x, unsigned y, unsigned k, struct fract_view *o)
+{
+	long double inc = fract_inc(f);
+	*o = f->view;
+	mpfix_add_long_double(&o->ulx_mp, x * inc);
+	mpfix_add_long_double(&o->uly_mp, -(y * inc));
+	o->span = f->view.span / k;
+	limits_round(o);
+}
+
+void fract_view_rows(const struct fract_view *v, unsigned height,
+		unsigned y, unsigned rows, struct fract_view *o)
+{
+	long double inc = v->span / (height - 1);
+	*o = *v;
+	mpfix_add_long_double(&o->uly_mp, -(y * inc));
+	o->span = (rows - 1) * inc;
+	limits_round(o);
+}
+
+struct colour_lut {
+	/* what it was built from */
+	float ratios[3];
+	const struct color_gradient *gradient;
+	float energyfactor;
+	/* mu times scale is the entry its colour is in */
+	float scale;
+	/* entries up to the first that is as bright as it gets, which is
+	 * as far as equalised colouring goes
+	 */
+	unsigned last;
+	unsigned char rgb[COLOUR_LUT_SIZE][3];
+};
+
+/* Ratios span from black to where the channel with the smallest of them
+ * saturates, past which every channel is at its brightest.
+ */
+static void colour_lut_ratios(struct colour_lut *lut)
+{
+	float rmin = 0;
+	for (unsigned c = 0; c < 3; c++)
+		if (lut->ratios[c] > 0 && (rmin == 0 || lut->ratios[c] < rmin))
+			rmin = lut->ratios[c];
+
+	if (rmin == 0) {
+		memset(lut->rgb, 0, sizeof(lut->rgb));
+		lut->scale = 0;
+		lut->last = 0;
+		return;
+	}
+
+	float top = 65535.0f / rmin;
+	for (unsigned k = 0; k < COLOUR_LUT_SIZE; k++) {
+		float factor = top * k / (COLOUR_LUT_SIZE - 1);
+		for (unsigned c = 0; c < 3; c++) {
+			uint32_t v = lut->ratios[c] * factor;
+			static const uint16_t cmax = ~0;
+			v = v > cmax ? cmax : v;
+			lut->rgb[k][c] = v >> 8;
+		}
+	}
+
+	lut->scale = lut->energyfactor * (COLOUR_LUT_SIZE - 1) / top;
+
+	float rmax = MAX(lut->ratios[0], MAX(lut->ratios[1], lut->ratios[2]));
+	lut->last = (COLOUR_LUT_SIZE - 1) * rmin / rmax;
+}
+
+static void colour_lut_gradient(struct colour_lut *lut)
+{
+	for (unsigned k = 0; k < COLOUR_LUT_SIZE; k++)
+		color_gradient_at(lut->gradient,
+				(float)k / (COLOUR_LUT_SIZE - 1), lut->rgb[k]);
+
+	lut->scale = lut->energyfactor * (COLOUR_LUT_SIZE - 1) / GRADIENT_SPAN;
+	lut->last = COLOUR_LUT_SIZE - 1;
+}
+
+static const struct colour_lut *colour_lut(struct fract *f, float energyfactor)
+{
+	const float ratios[] = { f->ratios.red, f->ratios.green, f->ratios.blue };
+	struct colour_lut *lut = f->lut;
+
+	if (lut && lut->gradient == f->gradient
+			&& lut->energyfactor == energyfactor
+			&& (f->gradient || memcmp(lut->ratios, ratios, sizeof(ratios)) == 0))
+		return lut;
+
+	if (!lut)
+		lut = f->lut = xmalloc(sizeof(*lut));
+	memcpy(lut->ratios, ratios, sizeof(ratios));
+	lut->gradient = f->gradient;
+	lut->energyfactor = energyfactor;
+
+	if (f->gradient)
+		colour_lut_gradient(lut);
+	else
+		colour_lut_ratios(lut);
+
+	return lut;
+}
+
+struct draw_job {
+	struct fract *f;
+	unsigned char *rgb;
+	size_t stride;
+	/* blocks this big take the colour of their top left pixel */
+	unsigned step;
+	const struct colour_lut *lut;
+	/* for equalised colouring, the entry of lut for every bin */
+	float lo;
+	float bin_scale;
+	const unsigned short *rank;
+};
+
+static void draw_band(void *data, unsigned band, unsigned thread)
+{
+	struct draw_job *job = data;
+	(void)thread;
+	struct fract *f = job->f;
+	struct mupoint *m = &f->mupoint;
+	unsigned width = f->width;
+	unsigned y0 = band * TILE_SIZE;
+	unsigned y1 = MIN(y0 + TILE_SIZE, f->height);
+	unsigned mask = ~(job->step - 1);
+	const struct colour_lut *lut = job->lut;
+	float scale = lut->scale;
+
+	for (unsigned j = y0; j < y1; j++) {
+		unsigned char *p = job->rgb + j * job->stride;
+		for (unsigned i = 0; i < width; i++) {
+			float v = MUPOINT_AT(m, i & mask, j & mask) * scale;
+			v = v > 0 ? v : 0;
+			v = v < COLOUR_LUT_SIZE - 1 ? v : COLOUR_LUT_SIZE - 1;
+			const unsigned char *c = lut->rgb[(unsigned)(v + 0.5f)];
+
+			*p++ = c[0];
+			*p++ = c[1];
+			*p++ = c[2];
+		}
+	}
+
+	if (f->progress)
+		f->progress(f->progress_data);
+}
+
+static inline unsigned histogram_bin(float mu, float lo, float scale)
+{
+	float b = (mu - lo) * scale;
+	b = b > 0 ? b : 0;
+	return b < HISTOGRAM_BINS - 1 ? b : HISTOGRAM_BINS - 1;
+}
+
+static void draw_band_equalised(void *data, unsigned band, unsigned thread)
+{
+	struct draw_job *job = data;
+	(void)thread;
+	struct fract *f = job->f;
+	struct mupoint *m = &f->mupoint;
+	unsigned width = f->width;
+	unsigned y0 = band * TILE_SIZE;
+	unsigned y1 = MIN(y0 + TILE_SIZE, f->height);
+	unsigned mask = ~(job->step - 1);
+	const struct colour_lut *lut = job->lut;
+
+	for (unsigned j = y0; j < y1; j++) {
+		unsigned char *p = job->rgb + j * job->stride;
+		for (unsigned i = 0; i < width; i++) {
+			gmandel_mu_t mu = MUPOINT_AT(m, i & mask, j & mask);
+			unsigned k = mu > 0 ? job->rank[histogram_bin(mu,
+					job->lo, job->bin_scale)] : 0;
+			const unsigned char *c = lut->rgb[k];
+
+			*p++ = c[0];
+			*p++ = c[1];
+			*p++ = c[2];
+		}
+	}
+
+	if (f->progress)
+		f->progress(f->progress_data);
+}
+
+/* Both passes only look at the pixels a coarse preview shows */
+struct histogram_job {
+	struct fract *f;
+	unsigned step;
+	struct {
+		float lo;
+		float hi;
+	} *range;
+	float lo;
+	float bin_scale;
+	uint32_t *bins;
+};
+
+static void histogram_range_band(void *data, unsigned band, unsigned thread)
+{
+	struct histogram_job *job = data;
+	struct fract *f = job->f;
+	unsigned y1 = MIN((band + 1) * TILE_SIZE, f->height);
+	float lo = job->range[thread].lo;
+	float hi = job->range[thread].hi;
+
+	for (unsigned j = band * TILE_SIZE; j < y1; j += job->step)
+		for (unsigned i = 0; i < f->width; i += job->step) {
+			gmandel_mu_t mu = MUPOINT_AT(&f->mupoint, i, j);
+			if (mu <= 0)
+				continue;
+			lo = mu < lo || lo == 0 ? mu : lo;
+			hi = mu > hi ? mu : hi;
+		}
+
+	job->range[thread].lo = lo;
+	job->range[thread].hi = hi;
+}
+
+static void histogram_band(void *data, unsigned band, unsigned thread)
+{
+	struct histogram_job *job = data;
+	struct fract *f = job->f;
+	unsigned y1 = MIN((band + 1) * TILE_SIZE, f->height);
+	uint32_t *bins = job->bins + (size_t)thread * HISTOGRAM_BINS;
+
+	for (unsigned j = band * TILE_SIZE; j < y1; j += job->step)
+		for (unsigned i = 0; i < f->width; i += job->step) {
+			gmandel_mu_t mu = MUPOINT_AT(&f->mupoint, i, j);
+			if (mu > 0)
+				bins[histogram_bin(mu, job->lo, job->bin_scale)]++;
+		}
+}
+
+/* Every thread counts its bands into bins of its own, which are added
+ * up at the end. A pixel gets the entry of the colour table as far
+ * along it, up to last, as the share of pixels with a mu no larger than
+ * its own.
+ */
+static unsigned short *histogram_rank(struct fract *f, unsigned step,
+		unsigned last, float *lo, float *bin_scale)
+{
+	unsigned nthreads = tilepool_get_nthreads(f->pool);
+	unsigned nbands = DIV_ROUND_UP(f->height, TILE_SIZE);
+	struct histogram_job job = {
+		.f = f,
+		.step = step,
+	};
+
+	job.range = xmalloc(nthreads * sizeof(*job.range));
+	for (unsigned t = 0; t < nthreads; t++)
+		job.range[t].lo = job.range[t].hi = 0;
+	bool done = tilepool_run(f->pool, nbands,
+			histogram_range_band, &job, &f->stop);
+	for (unsigned t = 1; t < nthreads; t++) {
+		if (job.range[t].lo > 0 && (job.range[0].lo == 0
+					|| job.range[t].lo < job.range[0].lo))
+			job.range[0].lo = job.range[t].lo;
+		if (job.range[t].hi > job.range[0].hi)
+			job.range[0].hi = job.range[t].hi;
+	}
+	job.lo = job.range[0].lo;
+	float width = job.range[0].hi - job.range[0].lo;
+	job.bin_scale = width > 0 ? (HISTOGRAM_BINS - 1) / width : 0;
+	free(job.range);
+	if (!done)
+		return NULL;
+
+	job.bins = xmalloc((size_t)nthreads * HISTOGRAM_BINS * sizeof(*job.bins));
+	memset(job.bins, 0, (size_t)nthreads * HISTOGRAM_BINS * sizeof(*job.bins));
+	if (!tilepool_run(f->pool, nbands, histogram_band, &job, &f->stop)) {
+		free(job.bins);
+		return NULL;
+	}
+
+	uint64_t total = 0;
+	for (unsigned b = 0; b < HISTOGRAM_BINS; b++) {
+		for (unsigned t = 1; t < nthreads; t++)
+			job.bins[b] += job.bins[(size_t)t * HISTOGRAM_BINS + b];
+		total += job.bins[b];
+	}
+
+	unsigned short *rank = xmalloc(HISTOGRAM_BINS * sizeof(*rank));
+	uint64_t below = 0;
+	for (unsigned b = 0; b < HISTOGRAM_BINS; b++) {
+		below += job.bins[b];
+		rank[b] = total ? below * last / total : 0;
+	}
+	free(job.bins);
+
+	*lo = job.lo;
+	*bin_scale = job.bin_scale;
+	return rank;
+}
+
+bool fract_colour(struct fract *f, unsigned char *rgb, size_t stride)
+{
+	return fract_colour_coarse(f, rgb, stride, 1);
+}
+
+bool fract_colour_coarse(struct fract *f,
+		unsigned char *rgb, size_t stride, unsigned step)
+{
+	long double avg;
+	if (f->avgfactor.n > 0)
+		avg = f->avgfactor.v / f->avgfactor.n;
+	else
+		avg = 1;
+
+	struct draw_job job = {
+		.f = f,
+		.rgb = rgb,
+		.stride = stride,
+		.step = step,
+		.lut = colour_lut(f, do_energyfactor(avg, 0.2, 0.8) * 1000),
+	};
+
+	if (!f->equalise)
+		return tilepool_run(f->pool, DIV_ROUND_UP(f->height, TILE_SIZE),
+				draw_band, &job, &f->stop);
+
+	unsigned short *rank = histogram_rank(f, step, job.lut->last,
+			&job.lo, &job.bin_scale);
+	if (!rank)
+		return false;
+	job.rank = rank;
+	bool done = tilepool_run(f->pool, DIV_ROUND_UP(f->height, TILE_SIZE),
+			draw_band_equalised, &job, &f->stop);
+	free(rank);
+	return done;
+}
+
+/* Counted the way renders count the pixels they compute */
+static void energy_rect(const struct fract *f,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		long double *v, unsigned *n)
+{
+	*v = 0;
+	*n = 0;
+	for (unsigned j = y0; j < y1; j++)
+		for (unsigned i = x0; i < x1; i++) {
+			gmandel_mu_t mu = MUPOINT_AT(&f->mupoint, i, j);
+			if (mu > 0) {
+				*v += mu;
+				(*n)++;
+			}
+		}
+}
+
+/* Takes out the pixels about to be scrolled away */
+static void energy_drop(struct fract *f,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+	long double v;
+	unsigned n;
+	energy_rect(f, x0, y0, x1, y1, &v, &n);
+	if (n > f->avgfactor.n) {
+		fract_clean_energy(f);
+		return;
+	}
+	f->avgfactor.v -= v;
+	f->avgfactor.n -= n;
+}
+
+void fract_energy(struct fract *f)
+{
+	energy_rect(f, 0, 0, f->width, f->height,
+			&f->avgfactor.v, &f->avgfactor.n);
+}
+
+struct pending_list {
+	struct fract_pending *p;
+	size_t n;
+	size_t size;
+};
+
+#define PENDING_INITIAL 256
+
+struct mu_job {
+	struct fract *f;
+	unsigned tiles_x;
+	/* only pixels on a grid this coarse are computed */
+	unsigned step;
+	enum fract_precision precision;
+	long double ulx;
+	long double uly;
+	long double inc;
+#if defined(GMANDEL_HAVE_FLOAT128)
+	gmandel_float128 ulx_f128;
+	gmandel_float128 uly_f128;
+	gmandel_float128 inc_f128;
+#endif
+	struct interior_check interior;
+	const struct interior_check *ic;
+	struct perturb_ref ref;
+	unsigned ref_i;
+	unsigned ref_j;
+	struct {
+		long double v;
+		unsigned n;
+		unsigned glitches;
+	} *acc;
+	/* per thread, NULL unless unresolved pixels are being kept */
+	struct pending_list *pending;
+	/* what fract_continue() asked to carry on */
+	const struct fract_pending *carry;
+	size_t ncarry;
+	/* distance estimates are used for colouring, for skipping tiles */
+	bool distance;
+	bool far;
+	/* whether do_mu_rect() may fill rectangles from their border */
+	bool subdivide;
+};
+
+/* Renormalized formula for the escape radius.
+ * Optimize away the case where it == 0
+ */
+static inline long double mu_from_it(unsigned it, long double modulus)
+{
+	if (it == 0)
+		return 0L;
+	long double mu = it - logl(fabsl(logl(modulus)));
+	mu /= M_LN2;
+	return mu < 0 ? 0 : mu;
+}
+
+static inline void store_mu(struct mupoint *m, unsigned i, unsigned j,
+		unsigned it, long double modulus,
+		long double *acc, unsigned *nacc)
+{
+	long double mu = mu_from_it(it, modulus);
+	MUPOINT_AT(m, i, j) = mu;
+	if (mu > 0) {
+		*acc += mu;
+		(*nacc)++;
+	}
+}
+
+/* Colouring by distance stores this many bands for every halving of the
+ * estimated distance to the boundary, in pixels. Anything closer than
+ * 2^-64 pixels is as close as it gets.
+ */
+#define DISTANCE_BANDS 64
+
+static inline long double mu_from_distance(unsigned it,
+		long double distance, long double inc)
+{
+	if (it == 0)
+		return 0L;
+	return DISTANCE_BANDS * log2l(1 + inc / MAX(distance, inc * 0x1p-64L));
+}
+
+static void pending_push(struct pending_list *l, unsigned i, unsigned j,
+		const struct orbit_resume *r)
+{
+	if (l->n == l->size) {
+		l->size *= 2;
+		l->p = xrealloc(l->p, l->size * sizeof(*l->p));
+	}
+	l->p[l->n].i = i;
+	l->p[l->n].j = j;
+	l->p[l->n].r = *r;
+	l->n++;
+}
+
+/* r is where each of the n pixels was left, or NULL when not recording
+ * unresolved pixels into pending.
+ */
+static void do_mu_simd(struct mu_job *job,
+		const unsigned *pi, const unsigned *pj, unsigned n,
+		struct orbit_resume *r, struct pending_list *pending,
+		long double *acc, unsigned *nacc)
+{
+	struct fract *f = job->f;
+	struct mupoint *m = &f->mupoint;
+	enum simd_precision p = job->precision == FRACT_PRECISION_FLOAT
+		? SIMD_SINGLE : SIMD_DOUBLE;
+	double px[TILE_SIZE];
+	double py[TILE_SIZE];
+	unsigned it[TILE_SIZE];
+	double modulus[TILE_SIZE];
+
+	for (unsigned k = 0; k < n; k++) {
+		px[k] = job->ulx + pi[k] * job->inc;
+		py[k] = job->uly - pj[k] * job->inc;
+	}
+
+	if (f->type == FRACT_MANDELBROT)
+		simd_mandelbrot_it(p, f->maxit, px, py, job->ic, r,
+				n, it, modulus);
+	else if (f->type == FRACT_JULIA)
+		simd_julia_it(p, f->maxit, px, py, f->cx, f->cy, r,
+				n, it, modulus);
+	else if (f->type == FRACT_BURNINGSHIP)
+		simd_burningship_it(p, f->maxit, px, py, job->ic, r,
+				n, it, modulus);
+
+	for (unsigned k = 0; k < n; k++) {
+		store_mu(m, pi[k], pj[k], it[k], modulus[k], acc, nacc);
+		if (r && r[k].it)
+			pending_push(pending, pi[k], pj[k], &r[k]);
+	}
+}
+
+static void do_mu_pixel(struct mu_job *job, unsigned i, unsigned j,
+		struct orbit_resume *r, struct pending_list *pending,
+		long double *acc, unsigned *nacc)
+{
+	struct fract *f = job->f;
+	long double x = job->ulx + i * job->inc;
+	long double y = job->uly - j * job->inc;
+	long double modulus;
+	unsigned it = 0;
+
+	if (f->type == FRACT_MANDELBROT)
+		it = mandelbrot_it(f->maxit, &x, &y, job->ic, r, &modulus);
+	else if (f->type == FRACT_JULIA)
+		it = julia_it(f->maxit, &x, &y, &f->cx, &f->cy, r, &modulus);
+	else if (f->type == FRACT_BURNINGSHIP)
+		it = burningship_it(f->maxit, &x, &y, job->ic, r, &modulus);
+
+	store_mu(&f->mupoint, i, j, it, modulus, acc, nacc);
+	if (r && r->it)
+		pending_push(pending, i, j, r);
+}
+
+static void do_mu_row_simd(struct mu_job *job,
+		unsigned x0, unsigned x1, unsigned j,
+		struct pending_list *pending,
+		long double *acc, unsigned *nacc)
+{
+	struct mupoint *m = &job->f->mupoint;
+	unsigned pi[TILE_SIZE];
+	unsigned pj[TILE_SIZE];
+	struct orbit_resume r[TILE_SIZE];
+	unsigned n = 0;
+
+	for (unsigned i = x0; i < x1; i += job->step) {
+		if (MUPOINT_AT(m, i, j) != -1L)
+			continue;
+		pi[n] = i;
+		pj[n] = j;
+		r[n++].it = 0;
+	}
+
+	do_mu_simd(job, pi, pj, n, pending ? r : NULL, pending, acc, nacc);
+}
+
+static void do_mu_row(struct mu_job *job,
+		unsigned x0, unsigned x1, unsigned j,
+		struct pending_list *pending,
+		long double *acc, unsigned *nacc)
+{
+	struct mupoint *m = &job->f->mupoint;
+
+	for (unsigned i = x0; i < x1; i += job->step) {
+		if (MUPOINT_AT(m, i, j) != -1L)
+			continue;
+		struct orbit_resume r = { .it = 0 };
+		do_mu_pixel(job, i, j, pending ? &r : NULL, pending,
+				acc, nacc);
+	}
+}
+
+static unsigned do_de_it(struct mu_job *job, long double x, long double y,
+		long double *distance)
+{
+	struct fract *f = job->f;
+
+	if (f->type == FRACT_MANDELBROT)
+		return mandelbrot_de_it(f->maxit, &x, &y, job->ic,
+				NULL, distance);
+	return julia_de_it(f->maxit, &x, &y, &f->cx, &f->cy,
+			NULL, distance);
+}
+
+static void do_mu_row_distance(struct mu_job *job,
+		unsigned x0, unsigned x1, unsigned j,
+		long double *acc, unsigned *nacc)
+{
+	struct mupoint *m = &job->f->mupoint;
+
+	long double y = job->uly - j * job->inc;
+	for (unsigned i = x0; i < x1; i += job->step) {
+		if (MUPOINT_AT(m, i, j) != -1L)
+			continue;
+
+		long double distance;
+		unsigned it = do_de_it(job, job->ulx + i * job->inc, y,
+				&distance);
+		long double mu = mu_from_distance(it, distance, job->inc);
+		MUPOINT_AT(m, i, j) = mu;
+		if (mu > 0) {
+			*acc += mu;
+			(*nacc)++;
+		}
+	}
+}
+
+#if defined(GMANDEL_HAVE_FLOAT128)
+static void do_mu_row_f128(struct mu_job *job,
+		unsigned x0, unsigned x1, unsigned j,
+		long double *acc, unsigned *nacc)
+{
+	struct fract *f = job->f;
+	struct mupoint *m = &f->mupoint;
+	gmandel_float128 cx = f->cx;
+	gmandel_float128 cy = f->cy;
+
+	gmandel_float128 y = job->uly_f128 - j * job->inc_f128;
+	for (unsigned i = x0; i < x1; i += job->step) {
+		if (MUPOINT_AT(m, i, j) != -1L)
+			continue;
+
+		gmandel_float128 x = job->ulx_f128 + i * job->inc_f128;
+		long double modulus;
+		unsigned it = 0;
+		if (f->type == FRACT_MANDELBROT)
+			it = mandelbrot_it_f128(f->maxit, &x, &y, &modulus);
+		else if (f->type == FRACT_JULIA)
+			it = julia_it_f128(f->maxit, &x, &y, &cx, &cy, &modulus);
+		else if (f->type == FRACT_BURNINGSHIP)
+			it = burningship_it_f128(f->maxit, &x, &y, &modulus);
+
+		store_mu(m, i, j, it, modulus, acc, nacc);
+	}
+}
+#endif
+
+static void do_mu_row_perturb(struct mu_job *job,
+		unsigned x0, unsigned x1, unsigned j,
+		long double *acc, unsigned *nacc, unsigned *glitches)
+{
+	struct fract *f = job->f;
+	struct mupoint *m = &f->mupoint;
+
+	long double dy = ((long double)job->ref_j - j) * job->inc;
+	for (unsigned i = x0; i < x1; i += job->step) {
+		if (MUPOINT_AT(m, i, j) != -1L)
+			continue;
+
+		long double dx = ((long double)i - job->ref_i) * job->inc;
+		long double modulus;
+		bool glitched;
+		unsigned it = perturb_it(&job->ref, f->maxit, dx, dy,
+				&modulus, &glitched);
+
+		/* left uncomputed for the next reference */
+		if (glitched) {
+			(*glitches)++;
+			continue;
+		}
+
+		store_mu(m, i, j, it, modulus, acc, nacc);
+	}
+}
+
+static void do_mu_span(struct mu_job *job,
+		unsigned x0, unsigned x1, unsigned j,
+		struct pending_list *pending,
+		long double *acc, unsigned *nacc, unsigned *glitches)
+{
+	if (job->distance) {
+		do_mu_row_distance(job, x0, x1, j, acc, nacc);
+		return;
+	}
+
+	switch (job->precision) {
+		case FRACT_PRECISION_FLOAT:
+		case FRACT_PRECISION_DOUBLE:
+			do_mu_row_simd(job, x0, x1, j, pending, acc, nacc);
+			break;
+#if defined(GMANDEL_HAVE_FLOAT128)
+		case FRACT_PRECISION_FLOAT128:
+			do_mu_row_f128(job, x0, x1, j, acc, nacc);
+			break;
+#endif
+		case FRACT_PRECISION_PERTURBATION:
+			do_mu_row_perturb(job, x0, x1, j, acc, nacc, glitches);
+			break;
+		default:
+			do_mu_row(job, x0, x1, j, pending, acc, nacc);
+			break;
+	}
+}
+
+/* Interior pixels are told apart from escaping ones with mu clamped to
+ * zero only by their colour, which is the same.
+ */
+static inline long double mu_band(gmandel_mu_t mu)
+{
+	return mu == 0 ? -1 : floorl(mu);
+}
+
+/* Past a spread of half a band the blend in fill_rect starts to show */
+#define FILL_MAX_SPREAD 0.5L
+
+struct border_check {
+	long double band;
+	long double lo;
+	long double hi;
+};
+
+static inline bool border_check_pixel(struct border_check *c, gmandel_mu_t mu)
+{
+	if (mu < 0 || mu_band(mu) != c->band)
+		return false;
+	c->lo = MIN(c->lo, mu);
+	c->hi = MAX(c->hi, mu);
+	return true;
+}
+
+static bool border_uniform(struct mupoint *m,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+	struct border_check c = {
+		.band = mu_band(MUPOINT_AT(m, x0, y0)),
+		.lo = MUPOINT_AT(m, x0, y0),
+		.hi = MUPOINT_AT(m, x0, y0),
+	};
+
+	for (unsigned i = x0; i < x1; i++)
+		if (!border_check_pixel(&c, MUPOINT_AT(m, i, y0))
+				|| !border_check_pixel(&c,
+					MUPOINT_AT(m, i, y1 - 1)))
+			return false;
+
+	for (unsigned j = y0; j < y1; j++)
+		if (!border_check_pixel(&c, MUPOINT_AT(m, x0, j))
+				|| !border_check_pixel(&c,
+					MUPOINT_AT(m, x1 - 1, j)))
+			return false;
+
+	return c.hi - c.lo < FILL_MAX_SPREAD;
+}
+
+/* Blends the four sides of the border, which keeps the smooth colouring
+ * of the band continuous across the filled rectangle.
+ */
+static void fill_rect(struct mupoint *m,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		long double *acc, unsigned *nacc)
+{
+	unsigned xl = x1 - 1;
+	unsigned yl = y1 - 1;
+	long double w = xl - x0;
+	long double h = yl - y0;
+	long double tl = MUPOINT_AT(m, x0, y0);
+	long double tr = MUPOINT_AT(m, xl, y0);
+	long double bl = MUPOINT_AT(m, x0, yl);
+	long double br = MUPOINT_AT(m, xl, yl);
+
+	for (unsigned j = y0 + 1; j < yl; j++) {
+		long double v = (j - y0) / h;
+		for (unsigned i = x0 + 1; i < xl; i++) {
+			if (MUPOINT_AT(m, i, j) != -1L)
+				continue;
+
+			long double u = (i - x0) / w;
+			long double mu = (1 - u) * MUPOINT_AT(m, x0, j)
+				+ u * MUPOINT_AT(m, xl, j)
+				+ (1 - v) * MUPOINT_AT(m, i, y0)
+				+ v * MUPOINT_AT(m, i, yl)
+				- (1 - u) * (1 - v) * tl - u * (1 - v) * tr
+				- (1 - u) * v * bl - u * v * br;
+
+			MUPOINT_AT(m, i, j) = mu;
+			if (mu > 0) {
+				*acc += mu;
+				(*nacc)++;
+			}
+		}
+	}
+}
+
+static void do_mu_border(struct mu_job *job,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		struct pending_list *pending,
+		long double *acc, unsigned *nacc, unsigned *glitches)
+{
+	do_mu_span(job, x0, x1, y0, pending, acc, nacc, glitches);
+	do_mu_span(job, x0, x1, y1 - 1, pending, acc, nacc, glitches);
+	for (unsigned j = y0 + 1; j < y1 - 1; j++) {
+		do_mu_span(job, x0, x0 + 1, j, pending, acc, nacc, glitches);
+		do_mu_span(job, x1 - 1, x1, j, pending, acc, nacc, glitches);
+	}
+}
+
+/* Mariani-Silver subdivision. The Mandelbrot set and the bands between
+ * escape counts are connected, so nothing else can hide inside a
+ * rectangle whose border lies in just one of them. Nobody knows that
+ * about the burning ship, so it is always evaluated point by point.
+ */
+#define SUBDIVIDE_MIN 6
+
+static void do_mu_rect(struct mu_job *job,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		long double *acc, unsigned *nacc, unsigned *glitches)
+{
+	struct fract *f = job->f;
+
+	if (x1 - x0 <= SUBDIVIDE_MIN || y1 - y0 <= SUBDIVIDE_MIN) {
+		for (unsigned j = y0; j < y1; j++)
+			do_mu_span(job, x0, x1, j, NULL, acc, nacc, glitches);
+		return;
+	}
+
+	do_mu_border(job, x0, y0, x1, y1, NULL, acc, nacc, glitches);
+	if (border_uniform(&f->mupoint, x0, y0, x1, y1)) {
+		fill_rect(&f->mupoint, x0, y0, x1, y1, acc, nacc);
+		return;
+	}
+
+	/* the halves share the middle row and column */
+	unsigned mx = (x0 + x1) / 2;
+	unsigned my = (y0 + y1) / 2;
+	do_mu_rect(job, x0, y0, mx + 1, my + 1, acc, nacc, glitches);
+	do_mu_rect(job, mx, y0, x1, my + 1, acc, nacc, glitches);
+	do_mu_rect(job, x0, my, mx + 1, y1, acc, nacc, glitches);
+	do_mu_rect(job, mx, my, x1, y1, acc, nacc, glitches);
+}
+
+static bool border_escaped(struct mupoint *m,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+	for (unsigned i = x0; i < x1; i++)
+		if (!(MUPOINT_AT(m, i, y0) > 0)
+				|| !(MUPOINT_AT(m, i, y1 - 1) > 0))
+			return false;
+
+	for (unsigned j = y0; j < y1; j++)
+		if (!(MUPOINT_AT(m, x0, j) > 0)
+				|| !(MUPOINT_AT(m, x1 - 1, j) > 0))
+			return false;
+
+	return true;
+}
+
+/* A tile whose centre is farther from the set than the diagonal of the
+ * tile, going by the lower bound of the distance estimate, has nothing
+ * but escaping points in it, and none escaping later than its border.
+ * Subdivision cannot miss anything there, so once the border has escaped
+ * the tile is subdivided whether it was asked for or not. Returns whether
+ * the tile was done like that.
+ */
+static bool do_mu_far(struct mu_job *job,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		struct pending_list *pending,
+		long double *acc, unsigned *nacc, unsigned *glitches)
+{
+	struct mupoint *m = &job->f->mupoint;
+	long double distance;
+	unsigned it = do_de_it(job,
+			job->ulx + (x0 + x1 - 1) * job->inc / 2,
+			job->uly - (y0 + y1 - 1) * job->inc / 2,
+			&distance);
+	long double diagonal = hypotl(x1 - 1 - x0, y1 - 1 - y0) * job->inc;
+
+	if (it == 0 || distance / 2 <= diagonal)
+		return false;
+
+	do_mu_border(job, x0, y0, x1, y1, pending, acc, nacc, glitches);
+	if (!border_escaped(m, x0, y0, x1, y1))
+		return false;
+
+	do_mu_rect(job, x0, y0, x1, y1, acc, nacc, glitches);
+	return true;
+}
+
+static void do_mu_tile(void *data, unsigned tile, unsigned thread)
+{
+	struct mu_job *job = data;
+	struct fract *f = job->f;
+	unsigned x0 = (tile % job->tiles_x) * TILE_SIZE;
+	unsigned y0 = (tile / job->tiles_x) * TILE_SIZE;
+	unsigned x1 = MIN(x0 + TILE_SIZE, f->width);
+	unsigned y1 = MIN(y0 + TILE_SIZE, f->height);
+	long double acc = 0;
+	unsigned nacc = 0;
+	unsigned glitches = 0;
+
+	struct pending_list *pending = job->pending
+		? &job->pending[thread] : NULL;
+	size_t kept = pending ? pending->n : 0;
+
+	bool filled = job->far && job->step == 1
+		&& do_mu_far(job, x0, y0, x1, y1, pending,
+				&acc, &nacc, &glitches);
+
+	/* tiles are aligned to every step coarse passes use */
+	if (!filled && job->subdivide && job->step == 1)
+		do_mu_rect(job, x0, y0, x1, y1, &acc, &nacc, &glitches);
+	else if (!filled)
+		for (unsigned j = y0; j < y1; j += job->step)
+			do_mu_span(job, x0, x1, j, pending,
+					&acc, &nacc, &glitches);
+
+	job->acc[thread].v += acc;
+	job->acc[thread].n += nacc;
+	job->acc[thread].glitches += glitches;
+
+	if (f->tile) {
+		bool done = job->step == 1;
+		for (unsigned j = y0; j < y1 && done; j++)
+			for (unsigned i = x0; i < x1 && done; i++)
+				done = MUPOINT_AT(&f->mupoint, i, j) >= 0;
+		f->tile(f->tile_data, x0, y0, x1, y1,
+				pending ? pending->p + kept : NULL,
+				pending ? pending->n - kept : 0, done);
+	}
+
+	if (f->progress)
+		f->progress(f->progress_data);
+}
+
+/* Pixels carried on from the last render are handed out this many at a
+ * time, in batches as wide as a tile row.
+ */
+#define CARRY_CHUNK (TILE_SIZE * TILE_SIZE)
+
+static void do_mu_carry(void *data, unsigned chunk, unsigned thread)
+{
+	struct mu_job *job = data;
+	struct fract *f = job->f;
+	size_t k0 = (size_t)chunk * CARRY_CHUNK;
+	size_t k1 = MIN(k0 + CARRY_CHUNK, job->ncarry);
+	struct pending_list *pending = &job->pending[thread];
+	long double acc = 0;
+	unsigned nacc = 0;
+
+	for (size_t k = k0; k < k1; k += TILE_SIZE) {
+		unsigned n = MIN(k1 - k, TILE_SIZE);
+		unsigned pi[TILE_SIZE];
+		unsigned pj[TILE_SIZE];
+		struct orbit_resume r[TILE_SIZE];
+
+		for (unsigned l = 0; l < n; l++) {
+			pi[l] = job->carry[k + l].i;
+			pj[l] = job->carry[k + l].j;
+			r[l] = job->carry[k + l].r;
+		}
+
+		if (job->precision == FRACT_PRECISION_LONG_DOUBLE)
+			for (unsigned l = 0; l < n; l++)
+				do_mu_pixel(job, pi[l], pj[l], &r[l], pending,
+						&acc, &nacc);
+		else
+			do_mu_simd(job, pi, pj, n, r, pending, &acc, &nacc);
+	}
+
+	job->acc[thread].v += acc;
+	job->acc[thread].n += nacc;
+
+	if (f->progress)
+		f->progress(f->progress_data);
+}
+
+/* Only the native types keep the orbit in something that can be stored
+ * and picked up again, and have kernels estimating distances.
+ */
+static inline bool precision_native(enum fract_precision p)
+{
+	return p == FRACT_PRECISION_FLOAT
+		|| p == FRACT_PRECISION_DOUBLE
+		|| p == FRACT_PRECISION_LONG_DOUBLE;
+}
+
+/* Swaps the pixels left unresolved by a render over the whole buffer in
+ * for the ones it started from. lists is NULL when none were kept.
+ */
+static void pending_finish(struct fract *f,
+		struct pending_list *lists, unsigned nthreads)
+{
+	size_t n = 0;
+	if (lists)
+		for (unsigned t = 0; t < nthreads; t++)
+			n += lists[t].n;
+
+	f->pending.p = xrealloc(f->pending.p, n * sizeof(*f->pending.p));
+	f->pending.n = 0;
+	if (lists)
+		for (unsigned t = 0; t < nthreads; t++) {
+			memcpy(f->pending.p + f->pending.n, lists[t].p,
+					lists[t].n * sizeof(*lists[t].p));
+			f->pending.n += lists[t].n;
+			free(lists[t].p);
+		}
+
+	f->pending.valid = lists && !f->stop && !f->pending.partial;
+	f->pending.view = f->view;
+	f->pending.width = f->width;
+	f->pending.height = f->height;
+	f->pending.maxit = f->maxit;
+	f->pending.cx = f->cx;
+	f->pending.cy = f->cy;
+}
+
+/* Orbits wander around |z| ~ 2 whatever the view, so that is the least
+ * magnitude we measure the pixel spacing against. A type is good enough
+ * when neighbouring pixels are still PRECISION_MARGIN ulps apart.
+ */
+#define PRECISION_MARGIN 1024
+
+static enum fract_precision pick_precision(const struct fract *f)
+{
+	long double inc = fract_inc(f);
+	long double mag = MAX(
+		MAX(fabsl(f->view.ulx),
+			fabsl(f->view.ulx + f->width * inc)),
+		MAX(fabsl(f->view.uly),
+			fabsl(f->view.lly)));
+	long double ulps = inc / (MAX(mag, 2.0L) * PRECISION_MARGIN);
+
+	if (ulps > FLT_EPSILON)
+		return FRACT_PRECISION_FLOAT;
+	else if (ulps > DBL_EPSILON)
+		return FRACT_PRECISION_DOUBLE;
+	else if (ulps > LDBL_EPSILON)
+		return FRACT_PRECISION_LONG_DOUBLE;
+	else if (f->type != FRACT_BURNINGSHIP)
+		return FRACT_PRECISION_PERTURBATION;
+#if defined(GMANDEL_HAVE_FLOAT128)
+	return FRACT_PRECISION_FLOAT128;
+#else
+	return FRACT_PRECISION_LONG_DOUBLE;
+#endif
+}
+
+static void rendered_record(struct fract *f)
+{
+	f->rendered.valid = true;
+	f->rendered.view = f->view;
+	f->rendered.width = f->width;
+	f->rendered.height = f->height;
+	f->rendered.maxit = f->maxit;
+	f->rendered.cx = f->cx;
+	f->rendered.cy = f->cy;
+	f->rendered.subdivide = f->subdivide;
+	f->rendered.interior_checks = f->interior_checks;
+	f->rendered.distance_fill = f->distance_fill;
+	f->rendered.colouring = f->colouring;
+	f->rendered.precision = f->precision;
+}
+
+/* Whole pixels of the last render from its top left corner to ours */
+static bool zoom_offset(const struct mpfix *from, const struct mpfix *to,
+		long double inc, long *offset)
+{
+	struct mpfix d;
+	mpfix_sub(&d, to, from);
+	long double o = mpfix_to_long_double(&d) / inc;
+	*offset = lroundl(o);
+	return fabsl(o - *offset) < ZOOM_EPS;
+}
+
+/* The glitched pixel in the middle of the scan is as good a guess as any
+ * for one whose orbit stays close to those of the rest. Subdivision may
+ * try a glitched pixel more than once, so they are counted again here.
+ */
+static void pick_reference(struct fract *f, unsigned step,
+		unsigned *ri, unsigned *rj)
+{
+	struct mupoint *m = &f->mupoint;
+	unsigned n = 0;
+
+	for (unsigned j = 0; j < f->height; j += step)
+		for (unsigned i = 0; i < f->width; i += step)
+			if (MUPOINT_AT(m, i, j) == -1L)
+				n++;
+	n /= 2;
+
+	for (unsigned j = 0; j < f->height; j += step)
+		for (unsigned i = 0; i < f->width; i += step)
+			if (MUPOINT_AT(m, i, j) == -1L && n-- == 0) {
+				*ri = i;
+				*rj = j;
+				return;
+			}
+}
+
+/* Each pass leaves glitched pixels uncomputed and the next one gives them
+ * a reference of their own, which is never glitched against itself.
+ * Whatever is left after f->references passes is done in long double.
+ */
+#define REFERENCES_DEFAULT 16
+
+static void do_mu_perturb(struct fract *f, struct mu_job *job,
+		unsigned ntiles)
+{
+	unsigned nthreads = tilepool_get_nthreads(f->pool);
+	unsigned ri = f->width / 2;
+	unsigned rj = f->height / 2;
+	unsigned glitches = 0;
+
+	enum perturb_type type = f->type == FRACT_MANDELBROT
+		? PERTURB_MANDELBROT : PERTURB_JULIA;
+	perturb_ref_init(&job->ref, type, f->cx, f->cy);
+
+	for (unsigned r = 0; r < f->references; r++) {
+		struct mpfix x = f->view.ulx_mp;
+		struct mpfix y = f->view.uly_mp;
+		mpfix_add_long_double(&x, ri * job->inc);
+		mpfix_add_long_double(&y, -(rj * job->inc));
+		perturb_ref_compute(&job->ref, f->maxit, &x, &y);
+		job->ref_i = ri;
+		job->ref_j = rj;
+
+		for (unsigned i = 0; i < nthreads; i++)
+			job->acc[i].glitches = 0;
+
+		if (!tilepool_run(f->pool, ntiles,
+					do_mu_tile, job, &f->stop))
+			break;
+
+		glitches = 0;
+		for (unsigned i = 0; i < nthreads; i++)
+			glitches += job->acc[i].glitches;
+		if (!glitches)
+			break;
+
+		pick_reference(f, job->step, &ri, &rj);
+	}
+
+	perturb_ref_free(&job->ref);
+
+	if (glitches && !f->stop) {
+		job->precision = FRACT_PRECISION_LONG_DOUBLE;
+		tilepool_run(f->pool, ntiles,
+				do_mu_tile, job, &f->stop);
+	}
+}
+
+/* The energy average is kept up to date after every pass so that
+ * previews are coloured like the final image.
+ */
+static void merge_acc(struct fract *f, struct mu_job *job, unsigned nthreads)
+{
+	for (unsigned i = 0; i < nthreads; i++) {
+		f->avgfactor.v += job->acc[i].v;
+		f->avgfactor.n += job->acc[i].n;
+		job->acc[i].v = 0;
+		job->acc[i].n = 0;
+	}
+}
+
+/* Coarse passes only make sense when the whole buffer is to be computed.
+ * Each one computes a quarter of the pixels of the next.
+ */
+static unsigned first_step(const struct fract *f)
+{
+	if (!f->cleaned || f->coarse <= 1)
+		return 1;
+	return MIN(f->coarse, TILE_SIZE);
+}
+
+static void do_mu_pass(struct fract *f, struct mu_job *job, unsigned ntiles)
+{
+	job->precision = f->precision;
+	if (job->precision == FRACT_PRECISION_PERTURBATION)
+		do_mu_perturb(f, job, ntiles);
+	else
+		tilepool_run(f->pool, ntiles, do_mu_tile, job, &f->stop);
+}
+
+/* Mandelbrot renders are symmetric about the real axis and Julia ones
+ * about the origin. When that falls on a pixel or half way between two,
+ * pixels whose mirror image lies in the other half of the view are
+ * marked MU_MIRRORED before the last pass, and copied from it once that
+ * half is done.
+ */
+#define MU_MIRRORED (-2L)
+
+/* Axes closer than this fraction of a pixel to a mirror are taken as it */
+#define MIRROR_SNAP (1.0L / 1024)
+
+struct mirror {
+	/* the axis, or the origin, is at kx / 2, ky / 2 in pixels */
+	unsigned kx;
+	unsigned ky;
+	bool point;
+};
+
+static bool mirror_snap(long double v, unsigned max, unsigned *k)
+{
+	long double r = roundl(v);
+	if (fabsl(v - r) >= MIRROR_SNAP || r <= 0 || r > max)
+		return false;
+	*k = r;
+	return true;
+}
+
+static bool mirror_setup(const struct fract *f, struct mirror *mr)
+{
+	if (f->type == FRACT_BURNINGSHIP || f->height < 2)
+		return false;
+
+	long double inc = fract_inc(f);
+	long double ky = 2 * mpfix_to_long_double(&f->view.uly_mp) / inc;
+	long double kx = -2 * mpfix_to_long_double(&f->view.ulx_mp) / inc;
+	mr->point = f->type == FRACT_JULIA;
+	mr->kx = 0;
+
+	if (!mirror_snap(ky, 2 * (f->height - 1), &mr->ky))
+		return false;
+	return !mr->point || mirror_snap(kx, 2 * (f->width - 1), &mr->kx);
+}
+
+/* The columns of row j mirrored into the half before the axis, and the
+ * row they are mirrored to. Columns of Julia renders are mirrored too.
+ */
+static bool mirror_row(const struct fract *f, const struct mirror *mr,
+		unsigned j, unsigned *i0, unsigned *i1, unsigned *my)
+{
+	if (2 * j <= mr->ky || j > mr->ky)
+		return false;
+
+	*my = mr->ky - j;
+	*i0 = 0;
+	*i1 = f->width;
+	if (mr->point) {
+		*i0 = mr->kx > f->width - 1 ? mr->kx - (f->width - 1) : 0;
+		*i1 = MIN(mr->kx + 1, f->width);
+	}
+	return *i0 < *i1;
+}
+
+struct mirror_job {
+	struct mu_job *mu;
+	const struct mirror *mr;
+};
+
+static void mirror_mark_band(void *data, unsigned band, unsigned thread)
+{
+	struct mirror_job *job = data;
+	(void)thread;
+	struct fract *f = job->mu->f;
+	struct mupoint *m = &f->mupoint;
+	unsigned y0 = band * TILE_SIZE;
+	unsigned y1 = MIN(y0 + TILE_SIZE, f->height);
+	unsigned i0;
+	unsigned i1;
+	unsigned my;
+
+	for (unsigned j = y0; j < y1; j++) {
+		if (!mirror_row(f, job->mr, j, &i0, &i1, &my))
+			continue;
+		for (unsigned i = i0; i < i1; i++)
+			if (MUPOINT_AT(m, i, j) == -1L)
+				MUPOINT_AT(m, i, j) = MU_MIRRORED;
+	}
+}
+
+static void mirror_fill_band(void *data, unsigned band, unsigned thread)
+{
+	struct mirror_job *job = data;
+	struct fract *f = job->mu->f;
+	struct mupoint *m = &f->mupoint;
+	const struct mirror *mr = job->mr;
+	/* zero mu is left for mirror_finish() to take with the kept orbit */
+	bool kept = job->mu->pending != NULL;
+	unsigned y0 = band * TILE_SIZE;
+	unsigned y1 = MIN(y0 + TILE_SIZE, f->height);
+	long double acc = 0;
+	unsigned nacc = 0;
+	unsigned i0;
+	unsigned i1;
+	unsigned my;
+
+	for (unsigned j = y0; j < y1; j++) {
+		if (!mirror_row(f, mr, j, &i0, &i1, &my))
+			continue;
+
+		for (unsigned i = i0; i < i1; i++) {
+			if (MUPOINT_AT(m, i, j) != MU_MIRRORED)
+				continue;
+
+			gmandel_mu_t mu = MUPOINT_AT(m,
+					mr->point ? mr->kx - i : i, my);
+			if (mu == 0 && kept)
+				continue;
+
+			MUPOINT_AT(m, i, j) = mu;
+			if (mu > 0) {
+				acc += mu;
+				nacc++;
+			}
+		}
+	}
+
+	job->mu->acc[thread].v += acc;
+	job->mu->acc[thread].n += nacc;
+
+	if (f->progress)
+		f->progress(f->progress_data);
+}
+
+/* Mirrors the pixels kept by the render into those still marked, which
+ * are the ones copied from a zero mu. The orbit of the conjugate of c is
+ * the conjugate of that of c, and those of z_0 and -z_0 are the same from
+ * the first iteration on. Whatever is left marked was found inside, or
+ * is left uncomputed if the render was stopped.
+ */
+static void mirror_finish(struct fract *f, const struct mirror *mr,
+		bool kept)
+{
+	struct mupoint *m = &f->mupoint;
+
+	if (kept && f->pending.valid) {
+		size_t n = f->pending.n;
+		f->pending.p = xrealloc(f->pending.p,
+				2 * n * sizeof(*f->pending.p));
+		for (size_t k = 0; k < n; k++) {
+			struct fract_pending p = f->pending.p[k];
+			if (p.j > mr->ky || (mr->point && p.i > mr->kx))
+				continue;
+
+			p.j = mr->ky - p.j;
+			if (mr->point)
+				p.i = mr->kx - p.i;
+			else
+				p.r.y = -p.r.y;
+
+			if (p.j >= f->height || p.i >= f->width
+					|| MUPOINT_AT(m, p.i, p.j) != MU_MIRRORED)
+				continue;
+
+			MUPOINT_AT(m, p.i, p.j) = 0;
+			f->pending.p[f->pending.n++] = p;
+		}
+	}
+
+	for (unsigned j = 0; j < f->height; j++)
+		for (unsigned i = 0; i < f->width; i++)
+			if (MUPOINT_AT(m, i, j) == MU_MIRRORED)
+				MUPOINT_AT(m, i, j) = f->stop ? -1L : 0;
+}
+
+/* Orbits closer than this fraction of a pixel count as a cycle. Larger
+ * fractions start catching slowly escaping points near the boundary.
+ */
+#define PERIODICITY_DIVISOR 1024
+#define DERIVATIVE_EPS 1e-24L
+
+bool fract_compute(struct fract *f)
+{
+	unsigned nthreads = tilepool_get_nthreads(f->pool);
+	struct mu_job job = {
+		.f = f,
+		.tiles_x = DIV_ROUND_UP(f->width, TILE_SIZE),
+		.step = 1,
+		.precision = f->precision,
+		.ulx = mpfix_to_long_double(&f->view.ulx_mp),
+		.uly = mpfix_to_long_double(&f->view.uly_mp),
+		.inc = fract_inc(f),
+	};
+#if defined(GMANDEL_HAVE_FLOAT128)
+	job.ulx_f128 = mpfix_to_f128(&f->view.ulx_mp);
+	job.uly_f128 = mpfix_to_f128(&f->view.uly_mp);
+	job.inc_f128 = (gmandel_float128)f->view.span
+		/ (f->height - 1);
+#endif
+	unsigned nbands = DIV_ROUND_UP(f->height, TILE_SIZE);
+	unsigned ntiles = job.tiles_x * nbands;
+	struct mirror mr;
+	struct mirror_job mj = { .mu = &job, .mr = &mr };
+	bool mirrored = false;
+
+	if (f->interior_checks & FRACT_INTERIOR_PERIODICITY)
+		job.interior.eps = job.inc / PERIODICITY_DIVISOR;
+	if (f->interior_checks & FRACT_INTERIOR_DERIVATIVE)
+		job.interior.deriv_eps = DERIVATIVE_EPS;
+	job.ic = f->interior_checks ? &job.interior : NULL;
+
+	job.acc = xmalloc(nthreads * sizeof(*job.acc));
+	for (unsigned i = 0; i < nthreads; i++) {
+		job.acc[i].v = 0;
+		job.acc[i].n = 0;
+		job.acc[i].glitches = 0;
+	}
+
+	bool de = f->type != FRACT_BURNINGSHIP
+		&& precision_native(job.precision);
+	job.distance = de && f->colouring == FRACT_COLOUR_DISTANCE;
+	job.far = de && f->distance_fill;
+	job.subdivide = f->subdivide && f->type != FRACT_BURNINGSHIP;
+
+	bool keep = f->pending.carry_on || (f->cleaned && f->resume
+			&& !f->subdivide && !job.distance
+			&& precision_native(job.precision));
+	if (keep) {
+		job.pending = xmalloc(nthreads * sizeof(*job.pending));
+		/* never NULL, which would tell f->tile none are kept */
+		for (unsigned i = 0; i < nthreads; i++) {
+			job.pending[i].size = PENDING_INITIAL;
+			job.pending[i].p = xmalloc(PENDING_INITIAL
+					* sizeof(*job.pending[i].p));
+			job.pending[i].n = 0;
+		}
+	}
+
+	/* what fract_zoom() carried over along with their pixels, or
+	 * fract_load_rect() loaded
+	 */
+	if (keep && f->cleaned && f->pending.n) {
+		size_t size = f->pending.n * sizeof(*f->pending.p);
+		job.pending[0].p = xrealloc(job.pending[0].p, size);
+		memcpy(job.pending[0].p, f->pending.p, size);
+		job.pending[0].n = job.pending[0].size = f->pending.n;
+	}
+
+	if (f->pending.carry_on) {
+		job.carry = f->pending.p;
+		job.ncarry = f->pending.n;
+		tilepool_run(f->pool, DIV_ROUND_UP(job.ncarry, CARRY_CHUNK),
+				do_mu_carry, &job, &f->stop);
+		merge_acc(f, &job, nthreads);
+	} else {
+		for (job.step = first_step(f); job.step > 1; job.step /= 2) {
+			do_mu_pass(f, &job, ntiles);
+			merge_acc(f, &job, nthreads);
+			if (f->stop)
+				break;
+			if (f->preview)
+				f->preview(f->preview_data, job.step);
+		}
+
+		mirrored = !f->stop && mirror_setup(f, &mr);
+		if (mirrored)
+			tilepool_run(f->pool, nbands, mirror_mark_band,
+					&mj, &f->stop);
+
+		if (!f->stop) {
+			do_mu_pass(f, &job, ntiles);
+			merge_acc(f, &job, nthreads);
+		}
+
+		if (mirrored && !f->stop) {
+			tilepool_run(f->pool, nbands, mirror_fill_band,
+					&mj, &f->stop);
+			merge_acc(f, &job, nthreads);
+		}
+	}
+
+	/* renders over part of the buffer leave the pixels kept alone */
+	if (f->cleaned || f->pending.carry_on)
+		pending_finish(f, job.pending, nthreads);
+	if (mirrored)
+		mirror_finish(f, &mr, job.pending != NULL);
+	f->cleaned = false;
+	f->pending.carry_on = false;
+	if (f->stop)
+		f->rendered.valid = false;
+	else
+		rendered_record(f);
+
+	free(job.pending);
+	free(job.acc);
+
+	return !f->stop;
+}
+
+void fract_init(struct fract *f, enum fract_type type, unsigned nthreads)
+{
+	simd_init();
+
+	f->type = type;
+	f->width = f->height = 0;
+	fract_view_from_limits(&f->view,
+			LIMITS_ULX_DEFAULT,
+			LIMITS_ULY_DEFAULT,
+			LIMITS_LLY_DEFAULT);
+	f->maxit = 1000;
+	f->cx = f->cy = 0.0;
+	f->subdivide = false;
+	f->interior_checks = FRACT_INTERIOR_PERIODICITY;
+	f->ratios.red = f->ratios.blue = f->ratios.green = 0.5;
+	f->gradient = NULL;
+	f->lut = NULL;
+	f->equalise = false;
+	f->precision = FRACT_PRECISION_FLOAT;
+	f->references = REFERENCES_DEFAULT;
+	f->mupoint.mu = NULL;
+	f->mupoint.width = f->mupoint.height = 0;
+	f->mupoint.ox = f->mupoint.oy = 0;
+	f->avgfactor.v = 0;
+	f->avgfactor.n = 0;
+	f->pool = tilepool_new(nthreads);
+	f->stop = false;
+	f->progress = NULL;
+	f->progress_data = NULL;
+	f->coarse = 1;
+	f->preview = NULL;
+	f->preview_data = NULL;
+	f->tile = NULL;
+	f->tile_data = NULL;
+	f->cleaned = false;
+	f->resume = true;
+	f->distance_fill = false;
+	f->colouring = FRACT_COLOUR_ITERATIONS;
+	f->pending.p = NULL;
+	f->pending.n = 0;
+	f->pending.carry_on = false;
+	f->pending.valid = false;
+	f->pending.partial = false;
+	f->rendered.valid = false;
+}
+
+void fract_destroy(struct fract *f)
+{
+	tilepool_free(f->pool);
+	f->pool = NULL;
+	mupoint_free(&f->mupoint);
+	free(f->pending.p);
+	f->pending.p = NULL;
+	free(f->lut);
+	f->lut = NULL;
+}
+
+void fract_set_size(struct fract *f, unsigned width, unsigned height)
+{
+	/* a new size starts from a clean buffer */
+	if (width != f->mupoint.width || height != f->mupoint.height) {
+		fract_clean_energy(f);
+		f->rendered.valid = false;
+	}
+	f->width = width;
+	f->height = height;
+	mupoint_create_as_needed(&f->mupoint, width, height);
+}
+
+void fract_pixel_to_point(const struct fract *f,
+		unsigned px, unsigned py,
+		long double *x, long double *y)
+{
+	if (x)
+		*x = px * fract_inc(f)
+			+ mpfix_to_long_double(&f->view.ulx_mp);
+	if (y)
+		*y = -(py * fract_inc(f)
+			- mpfix_to_long_double(&f->view.uly_mp));
+}
+
+void fract_move_up(struct fract *f, unsigned n)
+{
+	mpfix_add_long_double(&f->view.uly_mp, n * fract_inc(f));
+	limits_round(&f->view);
+	if (n < f->height)
+		energy_drop(f, 0, f->height - n, f->width, f->height);
+	else
+		fract_clean_energy(f);
+	mupoint_move_up(&f->mupoint, n);
+	f->pending.valid = false;
+	f->rendered.valid = false;
+}
+
+void fract_move_down(struct fract *f, unsigned n)
+{
+	mpfix_add_long_double(&f->view.uly_mp, -(n * fract_inc(f)));
+	limits_round(&f->view);
+	if (n < f->height)
+		energy_drop(f, 0, 0, f->width, n);
+	else
+		fract_clean_energy(f);
+	mupoint_move_down(&f->mupoint, n);
+	f->pending.valid = false;
+	f->rendered.valid = false;
+}
+
+void fract_move_right(struct fract *f, unsigned n)
+{
+	mpfix_add_long_double(&f->view.ulx_mp, n * fract_inc(f));
+	limits_round(&f->view);
+	if (n < f->width)
+		energy_drop(f, 0, 0, n, f->height);
+	else
+		fract_clean_energy(f);
+	mupoint_move_right(&f->mupoint, n);
+	f->pending.valid = false;
+	f->rendered.valid = false;
+}
+
+void fract_move_left(struct fract *f, unsigned n)
+{
+	mpfix_add_long_double(&f->view.ulx_mp, -(n * fract_inc(f)));
+	limits_round(&f->view);
+	if (n < f->width)
+		energy_drop(f, f->width - n, 0, f->width, f->height);
+	else
+		fract_clean_energy(f);
+	mupoint_move_left(&f->mupoint, n);
+	f->pending.valid = false;
+	f->rendered.valid = false;
+}
+
+void fract_clean(struct fract *f)
+{
+	mupoint_clean(&f->mupoint);
+	fract_clean_energy(f);
+	f->pending.n = 0;
+	f->pending.valid = false;
+	f->pending.partial = false;
+	f->cleaned = true;
+	f->pending.carry_on = false;
+	f->rendered.valid = false;
+}
+
+void fract_load_mu(struct fract *f, const gmandel_mu_t *mu)
+{
+	struct mupoint *m = &f->mupoint;
+	m->ox = 0;
+	m->oy = 0;
+	memcpy(m->mu, mu, (size_t)f->width * f->height * sizeof(*mu));
+	f->pending.n = 0;
+	f->pending.valid = false;
+	f->pending.carry_on = false;
+	f->cleaned = false;
+	f->precision = pick_precision(f);
+	rendered_record(f);
+}
+
+void fract_load_rect(struct fract *f,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		const gmandel_mu_t *mu, const struct fract_pending *p, size_t n)
+{
+	struct mupoint *m = &f->mupoint;
+	long double v = 0;
+	unsigned nv = 0;
+
+	for (unsigned j = y0; j < y1; j++)
+		for (unsigned i = x0; i < x1; i++, mu++) {
+			MUPOINT_AT(m, i, j) = *mu;
+			if (*mu > 0) {
+				v += *mu;
+				nv++;
+			}
+		}
+
+	f->avgfactor.v += v;
+	f->avgfactor.n += nv;
+
+	/* fract_compute() takes them on as it does those fract_zoom() keeps */
+	if (!p) {
+		f->pending.partial = true;
+		return;
+	}
+	f->pending.p = xrealloc(f->pending.p,
+			(f->pending.n + n) * sizeof(*p));
+	memcpy(f->pending.p + f->pending.n, p, n * sizeof(*p));
+	f->pending.n += n;
+}
+
+void fract_load_pending(struct fract *f,
+		const struct fract_pending *p, size_t n)
+{
+	f->pending.n = 0;
+	if (p) {
+		f->pending.p = xrealloc(f->pending.p, n * sizeof(*p));
+		memcpy(f->pending.p, p, n * sizeof(*p));
+		f->pending.n = n;
+	}
+	f->pending.valid = p != NULL;
+	f->pending.partial = false;
+	f->pending.carry_on = false;
+	f->pending.view = f->view;
+	f->pending.width = f->width;
+	f->pending.height = f->height;
+	f->pending.maxit = f->maxit;
+	f->pending.cx = f->cx;
+	f->pending.cy = f->cy;
+	f->cleaned = false;
+	f->precision = pick_precision(f);
+	rendered_record(f);
+}
+
+static bool view_equal(const struct fract_view *a, const struct fract_view *b)
+{
+	return mpfix_equal(&a->ulx_mp, &b->ulx_mp)
+		&& mpfix_equal(&a->uly_mp, &b->uly_mp)
+		&& a->span == b->span;
+}
+
+bool fract_continue(struct fract *f)
+{
+	if (!f->resume || !f->pending.valid
+			|| f->colouring != FRACT_COLOUR_ITERATIONS
+			|| f->maxit <= f->pending.maxit
+			|| f->width != f->pending.width
+			|| f->height != f->pending.height
+			|| f->cx != f->pending.cx
+			|| f->cy != f->pending.cy
+			|| !view_equal(&f->view, &f->pending.view))
+		return false;
+
+	f->pending.carry_on = true;
+	return true;
+}
+
+/* Pixel i of the new view is at old + i * out / in of the old one. Its
+ * pixels come over only if computed at least as precisely as this view
+ * needs. Distances are measured in pixels, which zooming resizes.
+ */
+bool fract_zoom(struct fract *f)
+{
+	if (!f->rendered.valid
+			|| f->colouring != FRACT_COLOUR_ITERATIONS
+			|| f->rendered.width != f->width
+			|| f->rendered.height != f->height
+			|| f->rendered.maxit != f->maxit
+			|| f->rendered.cx != f->cx
+			|| f->rendered.cy != f->cy
+			|| f->rendered.subdivide != f->subdivide
+			|| f->rendered.interior_checks != f->interior_checks
+			|| f->rendered.distance_fill != f->distance_fill
+			|| f->rendered.colouring != f->colouring
+			|| pick_precision(f) > f->rendered.precision)
+		return false;
+
+	long double ratio = f->rendered.view.span / f->view.span;
+	unsigned in = 1;
+	unsigned out = 1;
+	if (ratio >= 1)
+		in = lroundl(ratio);
+	else
+		out = lroundl(1 / ratio);
+	if (in * out < 2 || fabsl(ratio * out / in - 1) > ZOOM_EPS)
+		return false;
+
+	long double inc = f->rendered.view.span / (f->height - 1);
+	long ox, oy;
+	if (!zoom_offset(&f->rendered.view.ulx_mp, &f->view.ulx_mp, inc, &ox)
+			|| !zoom_offset(&f->view.uly_mp,
+				&f->rendered.view.uly_mp, inc, &oy))
+		return false;
+
+	unsigned width = f->width;
+	unsigned height = f->height;
+	gmandel_mu_t *old = xmalloc((size_t)width * height * sizeof(*old));
+	gmandel_mu_t *p = old;
+	for (unsigned j = 0; j < height; j++)
+		for (unsigned i = 0; i < width; i++)
+			*p++ = MUPOINT_AT(&f->mupoint, i, j);
+
+	bool kept = f->pending.valid
+		&& view_equal(&f->pending.view, &f->rendered.view);
+
+	mupoint_clean(&f->mupoint);
+	fract_clean_energy(f);
+	for (unsigned j = 0; j < height; j += in) {
+		long oj = oy + (long)(j / in) * out;
+		if (oj < 0 || oj >= height)
+			continue;
+		for (unsigned i = 0; i < width; i += in) {
+			long oi = ox + (long)(i / in) * out;
+			if (oi < 0 || oi >= width)
+				continue;
+			gmandel_mu_t mu = old[(size_t)oj * width + oi];
+			MUPOINT_AT(&f->mupoint, i, j) = mu;
+			if (mu > 0) {
+				f->avgfactor.v += mu;
+				f->avgfactor.n++;
+			}
+		}
+	}
+	free(old);
+
+	/* the orbits kept for pixels coming over go with them */
+	size_t n = 0;
+	for (size_t k = 0; kept && k < f->pending.n; k++) {
+		struct fract_pending q = f->pending.p[k];
+		long di = (long)q.i - ox;
+		long dj = (long)q.j - oy;
+		if (di < 0 || dj < 0 || di % out || dj % out)
+			continue;
+		long i = di / out * in;
+		long j = dj / out * in;
+		if (i >= width || j >= height)
+			continue;
+		q.i = i;
+		q.j = j;
+		f->pending.p[n++] = q;
+	}
+
+	f->pending.n = n;
+	f->pending.valid = false;
+	f->pending.partial = !kept;
+	f->pending.carry_on = false;
+	f->cleaned = true;
+	f->rendered.valid = false;
+	return true;
+}
+
+void fract_clean_energy(struct fract *f)
+{
+	f->avgfactor.v = 0;
+	f->avgfactor.n = 0;
+}
+
+void fract_begin(struct fract *f)
+{
+	f->stop = false;
+	f->precision = pick_precision(f);
+}
+
+unsigned fract_ticks(const struct fract *f)
+{
+	unsigned tiles = DIV_ROUND_UP(f->width, TILE_SIZE)
+		* DIV_ROUND_UP(f->height, TILE_SIZE);
+	unsigned bands = DIV_ROUND_UP(f->height, TILE_SIZE);
+
+	if (f->pending.carry_on)
+		return DIV_ROUND_UP(f->pending.n, CARRY_CHUNK) + bands;
+
+	/* every coarse pass goes over all tiles and maybe a preview */
+	unsigned ticks = tiles + bands;
+	for (unsigned step = first_step(f); step > 1; step /= 2)
+		ticks += tiles + (f->preview ? bands : 0);
+
+	struct mirror mr;
+	if (mirror_setup(f, &mr))
+		ticks += bands;
+
+	return ticks;
+}
+
+void fract_stop(struct fract *f)
+{
+	f->stop = true;
+}
+
+const char *fract_precision_name(enum fract_precision p)
+{
+	static const char *names[] = {
+		[FRACT_PRECISION_FLOAT] = "float",
+		[FRACT_PRECISION_DOUBLE] = "double",
+		[FRACT_PRECISION_LONG_DOUBLE] = "long double",
+		[FRACT_PRECISION_FLOAT128] = "__float128",
+		[FRACT_PRECISION_PERTURBATION] = "perturbation",
+	};
+	return names[p];
+}
@@ -0,0 +1,292 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_FRACT_H_
+#define GMANDEL_FRACT_H_ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "color.h"
+#include "gfract_engines.h"
+#include "mpfix.h"
+#include "mupoint.h"
+
+/* The rendering pipeline without any GTK: iteration into the mu buffer,
+ * the energy average and colouring into a caller provided RGB buffer.
+ * GFractMandel is a client of this, and so is anything that wants to
+ * render without a display.
+ */
+
+enum fract_type {
+	FRACT_MANDELBROT = 0,
+	FRACT_JULIA,
+	FRACT_BURNINGSHIP,
+};
+
+/* Arithmetic used by the last render, picked from the zoom depth */
+enum fract_precision {
+	FRACT_PRECISION_FLOAT = 0,
+	FRACT_PRECISION_DOUBLE,
+	FRACT_PRECISION_LONG_DOUBLE,
+	FRACT_PRECISION_FLOAT128,
+	FRACT_PRECISION_PERTURBATION,
+};
+
+/* Early exits for interior points of Mandelbrot and burning ship renders
+ * in native precision, periodicity is on by default.
+ */
+enum fract_interior {
+	FRACT_INTERIOR_PERIODICITY = 1 << 0,
+	FRACT_INTERIOR_DERIVATIVE = 1 << 1,
+};
+
+/* What mu holds for escaping points: their smooth escape count, or a
+ * measure of how close they are to the boundary going by the distance
+ * estimate. Colouring by distance needs Mandelbrot or Julia renders in
+ * native precision, others colour by escape count regardless.
+ */
+enum fract_colouring {
+	FRACT_COLOUR_ITERATIONS = 0,
+	FRACT_COLOUR_DISTANCE,
+};
+
+/* The doubles are the view rounded for state files and the like, the
+ * rest is exact so zooming can go past them.
+ */
+struct fract_view {
+	double ulx;
+	double uly;
+	double lly;
+	struct mpfix ulx_mp;
+	struct mpfix uly_mp;
+	long double span;
+};
+
+/* A pixel the last render left unresolved, see fract_continue() */
+struct fract_pending {
+	unsigned i;
+	unsigned j;
+	struct orbit_resume r;
+};
+
+struct fract {
+	enum fract_type type;
+	unsigned width;
+	unsigned height;
+	struct fract_view view;
+	unsigned maxit;
+	long double cx;
+	long double cy;
+	bool subdivide;
+	unsigned interior_checks;
+	struct {
+		float red;
+		float blue;
+		float green;
+	} ratios;
+	/* colours escaping points instead of the ratios when not NULL */
+	const struct color_gradient *gradient;
+	/* Spread the colours by how mu ranks among the pixels on screen
+	 * instead of by how it compares to the energy average. Costs two
+	 * more passes over mu when colouring.
+	 */
+	bool equalise;
+	/* what fract_colour() maps mu through, kept for as long as the
+	 * colours and the energy factor stay the same
+	 */
+	struct colour_lut *lut;
+	enum fract_precision precision;
+	/* Perturbation tries this many reference orbits, at least one, each
+	 * for the pixels the ones before it glitched on, and renders what
+	 * is left in long double.
+	 */
+	unsigned references;
+	struct mupoint mupoint;
+	struct {
+		long double v;
+		unsigned n;
+	} avgfactor;
+	struct tilepool *pool;
+	volatile bool stop;
+	/* called from the rendering threads once per tile or band */
+	void (*progress)(void *data);
+	void *progress_data;
+	/* Renders over a cleaned buffer first compute one pixel in every
+	 * coarse x coarse block, a power of two up to 32, and halve that
+	 * until every pixel is done. preview is called after each of those
+	 * passes from the thread running fract_compute(), which may use
+	 * fract_colour_coarse() with the step just finished.
+	 */
+	unsigned coarse;
+	void (*preview)(void *data, unsigned step);
+	void *preview_data;
+	/* Called from the rendering threads after each pass over a tile of
+	 * a cleaned buffer, from x0, y0 to x1, y1, with the orbits the pass
+	 * kept there and whether the tile is now done. p is NULL when the
+	 * render keeps none. Pixels mirrored from others are only done,
+	 * with their orbits, once fract_compute() returns.
+	 */
+	void (*tile)(void *data,
+			unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+			const struct fract_pending *p, size_t n, bool done);
+	void *tile_data;
+	/* fract_clean() was called since the last fract_compute() */
+	bool cleaned;
+	/* keep unresolved pixels so a higher maxit can carry on with them */
+	bool resume;
+	/* blend tiles far enough from the set from their border, for
+	 * Mandelbrot and Julia renders in native precision
+	 */
+	bool distance_fill;
+	enum fract_colouring colouring;
+	struct {
+		struct fract_pending *p;
+		size_t n;
+		bool carry_on;
+		bool valid;
+		/* the buffer has pixels from before fract_zoom() that none
+		 * were kept for, so what the next render keeps is not all
+		 */
+		bool partial;
+		/* what the render that left them was looking at */
+		struct fract_view view;
+		unsigned width;
+		unsigned height;
+		unsigned maxit;
+		long double cx;
+		long double cy;
+	} pending;
+	/* what the last render that ran to the end left in the buffer */
+	struct {
+		bool valid;
+		struct fract_view view;
+		unsigned width;
+		unsigned height;
+		unsigned maxit;
+		long double cx;
+		long double cy;
+		bool subdivide;
+		unsigned interior_checks;
+		bool distance_fill;
+		enum fract_colouring colouring;
+		enum fract_precision precision;
+	} rendered;
+};
+
+void fract_init(struct fract *f, enum fract_type type, unsigned nthreads);
+void fract_destroy(struct fract *f);
+void fract_set_size(struct fract *f, unsigned width, unsigned height);
+
+void fract_view_from_limits(struct fract_view *v,
+		double ulx, double uly, double lly);
+void fract_view_box(const struct fract *f,
+		unsigned sx, unsigned sy, unsigned dx, unsigned dy,
+		struct fract_view *v);
+/* The view k times smaller with its top left corner at pixel (x, y),
+ * whose every k-th pixel is one of the current view's.
+ */
+void fract_view_zoom(const struct fract *f,
+		unsigned x, unsigned y, unsigned k, struct fract_view *v);
+/* Rows [y, y + rows) of v seen at height rows, rows being at least 2 */
+void fract_view_rows(const struct fract_view *v, unsigned height,
+		unsigned y, unsigned rows, struct fract_view *o);
+long double fract_inc(const struct fract *f);
+void fract_pixel_to_point(const struct fract *f,
+		unsigned px, unsigned py,
+		long double *x, long double *y);
+
+/* Moving the view keeps whatever mu is still visible, and takes what
+ * scrolls away out of the energy average
+ */
+void fract_move_up(struct fract *f, unsigned n);
+void fract_move_down(struct fract *f, unsigned n);
+void fract_move_right(struct fract *f, unsigned n);
+void fract_move_left(struct fract *f, unsigned n);
+
+/* A render is fract_begin(), fract_compute() and fract_colour().
+ * fract_ticks() is how many times the progress callback will be called
+ * along the way. fract_stop() makes the running step return early, and
+ * the render functions report whether they ran to the end.
+ *
+ * fract_compute() adds every pixel it computes to the energy average
+ * colouring goes by. fract_energy() counts it all over again, and
+ * fract_clean_energy() forgets it.
+ */
+void fract_clean(struct fract *f);
+void fract_clean_energy(struct fract *f);
+
+/* Instead of fract_clean(), when all that changed since the last render
+ * over the whole buffer is a higher maxit: the next fract_compute() only
+ * carries on with the pixels that ran out of iterations, from where they
+ * were left. Only float, double and long double renders coloured by
+ * escape count, without subdivision, keep them. Returns false, doing
+ * nothing, otherwise.
+ */
+bool fract_continue(struct fract *f);
+
+/* Instead of fract_clean(), when the view is now an integer zoom in or
+ * out of the last render's, on its pixel grid, and nothing else changed:
+ * the pixels both views share are carried over and the next
+ * fract_compute() only does the rest. Only renders coloured by escape
+ * count carry them. Returns false, doing nothing, otherwise.
+ */
+bool fract_zoom(struct fract *f);
+
+/* Instead of a render, mu for the whole buffer in row order from the top
+ * left pixel. The energy average is left for the caller to set.
+ */
+void fract_load_mu(struct fract *f, const gmandel_mu_t *mu);
+/* Or a rectangle of it at a time, in row order, from a render of the
+ * same view that may have been cut short: after fract_clean(), each
+ * rectangle is added to the energy average, and fract_compute() only
+ * does the pixels left. p has the n orbits fract_continue() needs that
+ * were kept in the rectangle, NULL if they were not. fract_load_pending()
+ * tells a buffer filled like that is a finished render, with the orbits
+ * it kept, if p is not NULL.
+ */
+void fract_load_rect(struct fract *f,
+		unsigned x0, unsigned y0, unsigned x1, unsigned y1,
+		const gmandel_mu_t *mu, const struct fract_pending *p, size_t n);
+void fract_load_pending(struct fract *f,
+		const struct fract_pending *p, size_t n);
+void fract_begin(struct fract *f);
+unsigned fract_ticks(const struct fract *f);
+bool fract_compute(struct fract *f);
+void fract_energy(struct fract *f);
+bool fract_colour(struct fract *f, unsigned char *rgb, size_t stride);
+bool fract_colour_coarse(struct fract *f,
+		unsigned char *rgb, size_t stride, unsigned step);
+void fract_stop(struct fract *f);
+
+const char *fract_precision_name(enum fract_precision p);
+
+#endif
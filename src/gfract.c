@@ -29,17 +29,18 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <math.h>
-#include <string.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 
 #include <gtk/gtk.h>
 
 #include "mandelbrot.h"
 #include "julia.h"
 #include "burningship.h"
-#include "color_filter.h"
-#include "mupoint.h"
+#include "checkpoint.h"
+#include "fract.h"
+#include "mucache.h"
 #include "xfuncs.h"
 #include "gfract.h"
 #include "gfract_engines.h"
@@ -48,17 +49,14 @@
 #define LIMITS_ULY_DEFAULT (1.1)
 #define LIMITS_LLY_DEFAULT (-1.1)
 
-struct observer_state {
-	double ulx;
-	double uly;
-	double lly;
-};
+/* The first pass of a progressive render computes 1/16 of the pixels */
+#define PROGRESSIVE_STEP 4
 
-enum gfract_type {
-	GFRACT_MANDEL = 0,
-	GFRACT_JULIA,
-	GFRACT_BURNINGSHIP,
-};
+/* How often, in milliseconds, the progress bar looks at the worker */
+#define PROGRESS_INTERVAL 100
+
+/* Memory for finished renders kept to go back to, in bytes */
+#define CACHE_BUDGET_DEFAULT (128 << 20)
 
 G_DEFINE_TYPE(GFractMandel, gfract_mandel, GTK_TYPE_DRAWING_AREA);
 
@@ -71,38 +69,82 @@ typedef struct _GFractMandelPrivate GFractMandelPrivate;
 struct _GFractMandelPrivate {
 	GdkPixmap *draw;
 	GdkPixmap *onscreen;
-	struct observer_state paint_limits;
-	struct mupoint mupoint;
-	struct {
-		long double v;
-		unsigned n;
-	} avgfactor;
+	guchar *rgb;
+	struct fract fract;
 	GtkWidget *progress;
-	float progress_stp;
-	float progress_cur;
+	/* The worker only ever bumps progress_done, and sets preview_ready
+	 * once preview_rgb holds a coarse pass. A timeout in the main loop
+	 * picks both up, and clears preview_ready when done with
+	 * preview_rgb. The final image goes to rgb, which the main loop
+	 * only reads once the worker is gone.
+	 */
+	guchar *preview_rgb;
+	unsigned progress_ticks;
+	volatile gint progress_done;
+	volatile gint preview_ready;
+	guint progress_source;
 	void (*progress_hook_start)(gpointer);
 	void (*progress_hook_finish)(gpointer);
 	gpointer progress_hook_start_data;
 	gpointer progress_hook_finish_data;
 	bool do_select;
 	bool do_orbits;
-	bool do_energy;
+	/* round selections to integer zooms, see gfract_set_snap_zoom() */
+	bool snap_zoom;
 	unsigned select_orig_x;
 	unsigned select_orig_y;
 	GSList *states;
-	unsigned maxit;
+	/* full renders, so going back to their views only colours them */
+	struct mucache cache;
+	/* full renders keep their tiles in checkpoint_name, when set, and
+	 * checkpointing says the one going on does
+	 */
+	gchar *checkpoint_name;
+	struct checkpoint checkpoint;
+	bool checkpointing;
+	/* Every render request gets the next generation. One made while the
+	 * worker is busy stops it at the next tile, and is started from the
+	 * main loop once the worker has handed its render back. Whatever a
+	 * request needs done to the buffer waits in next until then, as only
+	 * one of them may touch it at a time.
+	 */
 	GThread *worker;
-	bool stop_worker;
+	guint generation;
+	guint worker_generation;
+	bool worker_done;
+	/* the render is a full one nothing was kept for */
+	bool worker_store;
+	/* the pixmap on screen is the render of the latest request */
+	bool current;
+	struct {
+		bool queued;
+		bool resize;
+		bool compute;
+		int dx;
+		int dy;
+		/* set_view() was called with view */
+		bool set_view;
+		struct fract_view view;
+	} next;
+	/* What the setters were last told. The worker reads fract, so they
+	 * only reach it with settings_apply() once no worker is running.
+	 */
 	struct {
+		unsigned maxit;
+		long double cx;
+		long double cy;
+		bool subdivide;
+		unsigned interior_checks;
+		unsigned coarse;
+		bool resume;
+		bool distance_fill;
+		enum fract_colouring colouring;
+		bool equalise;
 		float red;
 		float blue;
 		float green;
-	} ratios;
-	unsigned width;
-	unsigned height;
-	enum gfract_type type;
-	long double cx;
-	long double cy;
+		const struct color_gradient *gradient;
+	} set;
 };
 
 static void gfract_mandel_finalize(GObject *object);
@@ -114,38 +156,27 @@ gfract_button_release(GtkWidget *widget, GdkEventButton *event);
 static gboolean gfract_motion(GtkWidget *widget, GdkEventMotion *event);
 static gboolean configure_fract(GtkWidget *widget, GdkEventConfigure *event);
 static gpointer run_worker(gpointer data);
-static void do_mu(GtkWidget *widget, unsigned begin, size_t n);
-static void draw(GtkWidget *widget);
-static void doenergy(GtkWidget *widget);
+static void render_start(GtkWidget *widget);
 
 static void progress_start(GtkWidget *widget, unsigned ticks);
-static void progress_tick(GtkWidget *widget);
+static gboolean progress_poll(gpointer data);
 static void progress_finish(GtkWidget *widget);
 
-static inline long double paint_inc(GtkWidget *widget)
-{
-	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	return (priv->paint_limits.uly - priv->paint_limits.lly)
-		/ (priv->height - 1);
-}
-
 void gfract_pixel_to_point(GtkWidget *widget,
 		unsigned px, unsigned py,
 		long double *x, long double *y)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	if (x)
-		*x = px * paint_inc(widget) + priv->paint_limits.ulx;
-	if (y)
-		*y = -(py * paint_inc(widget) - priv->paint_limits.uly);
+	fract_pixel_to_point(&priv->fract, px, py, x, y);
 }
 
 static inline void point_to_pixel(GtkWidget *widget,
 		struct orbit_point *o, gint *x, gint *y)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	*x = (o->x - priv->paint_limits.ulx) / paint_inc(widget);
-	*y = (priv->paint_limits.uly - o->y) / paint_inc(widget);
+	const struct fract *f = &priv->fract;
+	*x = (o->x - mpfix_to_long_double(&f->view.ulx_mp)) / fract_inc(f);
+	*y = (mpfix_to_long_double(&f->view.uly_mp) - o->y) / fract_inc(f);
 }
 
 static void gfract_mandel_class_init(GFractMandelClass *class)
@@ -164,6 +195,45 @@ static void gfract_mandel_class_init(GFractMandelClass *class)
 	g_type_class_add_private(object_class, sizeof(GFractMandelPrivate));
 }
 
+static void settings_init(GFractMandelPrivate *priv)
+{
+	const struct fract *f = &priv->fract;
+	priv->set.maxit = f->maxit;
+	priv->set.cx = f->cx;
+	priv->set.cy = f->cy;
+	priv->set.subdivide = f->subdivide;
+	priv->set.interior_checks = f->interior_checks;
+	priv->set.coarse = f->coarse;
+	priv->set.resume = f->resume;
+	priv->set.distance_fill = f->distance_fill;
+	priv->set.colouring = f->colouring;
+	priv->set.equalise = f->equalise;
+	priv->set.red = f->ratios.red;
+	priv->set.blue = f->ratios.blue;
+	priv->set.green = f->ratios.green;
+	priv->set.gradient = f->gradient;
+}
+
+/* Only ever called from the main loop with no worker running */
+static void settings_apply(GFractMandelPrivate *priv)
+{
+	struct fract *f = &priv->fract;
+	f->maxit = priv->set.maxit;
+	f->cx = priv->set.cx;
+	f->cy = priv->set.cy;
+	f->subdivide = priv->set.subdivide;
+	f->interior_checks = priv->set.interior_checks;
+	f->coarse = priv->set.coarse;
+	f->resume = priv->set.resume;
+	f->distance_fill = priv->set.distance_fill;
+	f->colouring = priv->set.colouring;
+	f->equalise = priv->set.equalise;
+	f->ratios.red = priv->set.red;
+	f->ratios.blue = priv->set.blue;
+	f->ratios.green = priv->set.green;
+	f->gradient = priv->set.gradient;
+}
+
 static void gfract_mandel_init(GFractMandel *fract)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(fract);
@@ -172,31 +242,35 @@ static void gfract_mandel_init(GFractMandel *fract)
 
 	priv->onscreen = NULL;
 	priv->draw = NULL;
+	priv->rgb = NULL;
+	priv->preview_rgb = NULL;
 
-	priv->paint_limits.ulx = LIMITS_ULX_DEFAULT;
-	priv->paint_limits.uly = LIMITS_ULY_DEFAULT;
-	priv->paint_limits.lly = LIMITS_LLY_DEFAULT;
+	fract_init(&priv->fract, FRACT_MANDELBROT, 0);
+	priv->fract.coarse = PROGRESSIVE_STEP;
+	settings_init(priv);
 
 	priv->do_select = false;
 	priv->do_orbits = false;
-	priv->do_energy = false;
-
-	priv->maxit = 1000;
+	priv->snap_zoom = false;
 
 	priv->states = NULL;
+	mucache_init(&priv->cache, CACHE_BUDGET_DEFAULT);
+	priv->checkpoint_name = NULL;
+	priv->checkpointing = false;
 
 	priv->worker = NULL;
-	priv->stop_worker = false;
-
-	priv->ratios.red = priv->ratios.blue = priv->ratios.green = 0.5;
-
-	priv->height = priv->width = 0;
-
-	priv->cx = priv->cy = 0.0;
+	priv->generation = 0;
+	priv->worker_generation = 0;
+	priv->worker_done = false;
+	priv->worker_store = false;
+	priv->current = false;
+	memset(&priv->next, 0, sizeof(priv->next));
 
 	priv->progress = NULL;
-	priv->progress_stp = 0;
-	priv->progress_cur = 0;
+	priv->progress_ticks = 0;
+	priv->progress_done = 0;
+	priv->preview_ready = 0;
+	priv->progress_source = 0;
 	priv->progress_hook_start = NULL;
 	priv->progress_hook_finish = NULL;
 	priv->progress_hook_start_data = NULL;
@@ -225,32 +299,37 @@ static void gfract_mandel_finalize(GObject *object)
 		priv->draw = NULL;
 	}
 
+	free(priv->rgb);
+	priv->rgb = NULL;
+	free(priv->preview_rgb);
+	priv->preview_rgb = NULL;
+
 	if (priv->states) {
 		g_slist_foreach(priv->states, (GFunc)free, NULL);
 		g_slist_free(priv->states);
 		priv->states = NULL;
 	}
 
-	if (priv->worker) {
-		g_thread_join(priv->worker);
-		priv->worker = NULL;
-	}
+	mucache_destroy(&priv->cache);
+	g_free(priv->checkpoint_name);
+	priv->checkpoint_name = NULL;
 
-	mupoint_free(&priv->mupoint);
+	/* a running worker holds a reference, so there is none by now */
+	fract_destroy(&priv->fract);
 
 	if (G_OBJECT_CLASS(gfract_mandel_parent_class)->finalize)
 		G_OBJECT_CLASS(gfract_mandel_parent_class)->finalize(object);
 }
 
-static GtkWidget *_new(guint width, guint height, enum gfract_type type)
+static GtkWidget *_new(guint width, guint height, enum fract_type type)
 {
 	GtkWidget *ret = g_object_new(GFRACT_TYPE_MANDEL, NULL);
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(ret);
 
-	priv->type = type;
+	priv->fract.type = type;
 
-	priv->width = width;
-	priv->height = height;
+	priv->fract.width = width;
+	priv->fract.height = height;
 
 	gtk_widget_set_size_request(ret, width, height);
 
@@ -259,43 +338,83 @@ static GtkWidget *_new(guint width, guint height, enum gfract_type type)
 
 GtkWidget *gfract_new_mandel(guint width, guint height)
 {
-	return _new(width, height, GFRACT_MANDEL);
+	return _new(width, height, FRACT_MANDELBROT);
 }
 
 GtkWidget *gfract_new_julia(guint width, guint height)
 {
-	return _new(width, height, GFRACT_JULIA);
+	return _new(width, height, FRACT_JULIA);
 }
 
 GtkWidget *gfract_new_burningship(guint width, guint height)
 {
-	return _new(width, height, GFRACT_BURNINGSHIP);
+	return _new(width, height, FRACT_BURNINGSHIP);
 }
 
 void gfract_compute(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	mupoint_clean(&priv->mupoint);
-	gfract_compute_partial(widget);
+	priv->next.compute = true;
+	gfract_redraw(widget);
 }
 
 void gfract_compute_partial(GtkWidget *widget)
 {
-	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->avgfactor.v = 0;
-	priv->avgfactor.n = 0;
 	gfract_redraw(widget);
 }
 
 void gfract_redraw(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->generation++;
+	priv->next.queued = true;
+	priv->current = false;
 	if (priv->worker)
-		g_thread_join(priv->worker);
-	if (priv->progress)
-		priv->worker = g_thread_create(run_worker, widget, TRUE, NULL);
+		fract_stop(&priv->fract);
 	else
-		run_worker(widget);
+		render_start(widget);
+}
+
+/* Only the colours changed: the finished render on screen is coloured
+ * again from its mu, right here. Anything else takes a render.
+ */
+void gfract_recolour(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	struct fract *f = &priv->fract;
+
+	if (!priv->current || priv->worker || priv->next.queued) {
+		gfract_redraw(widget);
+		return;
+	}
+
+	settings_apply(priv);
+	fract_begin(f);
+	f->progress = NULL;
+	f->preview = NULL;
+	if (!fract_colour(f, priv->rgb, f->width * 3))
+		return;
+
+	GdkGC *gc = gdk_gc_new(priv->onscreen);
+	gdk_draw_rgb_image(priv->onscreen, gc, 0, 0, f->width, f->height,
+			GDK_RGB_DITHER_NONE, priv->rgb, f->width * 3);
+	g_object_unref(gc);
+
+	if (GTK_WIDGET_REALIZED(widget))
+		gdk_window_invalidate_rect(widget->window, NULL, TRUE);
+}
+
+/* Views set from the main loop are relative to what is on screen, which
+ * moves still waiting for a render never made it to. The view waits for
+ * the next render like those do.
+ */
+static void set_view(GtkWidget *widget, const struct fract_view *v)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->next.set_view = true;
+	priv->next.view = *v;
+	priv->next.dx = 0;
+	priv->next.dy = 0;
 }
 
 static gboolean
@@ -315,8 +434,8 @@ gfract_button_press(GtkWidget *widget, GdkEventButton *event)
 	} else if (event->button == 3) {
 		if (priv->states == NULL)
 			return FALSE;
-		struct observer_state *o = priv->states->data;
-		memcpy(&priv->paint_limits, o, sizeof(*o));
+		struct fract_view *o = priv->states->data;
+		set_view(widget, o);
 		priv->states = g_slist_remove(priv->states, o);
 		free(o);
 		gfract_compute(widget);
@@ -342,13 +461,25 @@ gfract_button_release(GtkWidget *widget, GdkEventButton *event)
 
 	priv->do_select = false;
 
-	struct observer_state *o = xmalloc(sizeof(*o));
-	memcpy(o, &priv->paint_limits, sizeof(*o));
+	struct fract_view *o = xmalloc(sizeof(*o));
+	*o = priv->fract.view;
 	priv->states = g_slist_prepend(priv->states, o);
 
-	gfract_set_limits_box(widget,
-			priv->select_orig_x, priv->select_orig_y,
-			event->x, event->y);
+	unsigned sx = priv->select_orig_x;
+	unsigned sy = priv->select_orig_y;
+	unsigned dx = event->x;
+	unsigned dy = event->y;
+	unsigned height = MAX(sy, dy) - MIN(sy, dy);
+	unsigned k = (priv->fract.height + height / 2) / height;
+
+	if (priv->snap_zoom && k >= 2) {
+		unsigned width = priv->fract.width / k;
+		unsigned x = dx < sx ? sx - MIN(sx, width) : sx;
+		struct fract_view v;
+		fract_view_zoom(&priv->fract, x, MIN(sy, dy), k, &v);
+		set_view(widget, &v);
+	} else
+		gfract_set_limits_box(widget, sx, sy, dx, dy);
 
 	gfract_compute(widget);
 
@@ -412,202 +543,232 @@ static gboolean configure_fract(GtkWidget *widget, GdkEventConfigure *event)
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
 	GFractMandel *fract = GFRACT_MANDEL(widget);
 
-	if (priv->worker)
-		gfract_stop_wait(widget);
+	/* the worker only draws to onscreen with the lock we are holding */
 	if (priv->draw)
 		g_object_unref(priv->draw);
 	if (priv->onscreen)
 		g_object_unref(priv->onscreen);
+	unsigned width = priv->fract.width;
+	unsigned height = priv->fract.height;
 	priv->draw = gdk_pixmap_new(fract->parent_widget->window,
-			priv->width, priv->height, -1);
+			width, height, -1);
 	priv->onscreen = gdk_pixmap_new(fract->parent_widget->window,
-			priv->width, priv->height, -1);
+			width, height, -1);
 	gdk_draw_rectangle(priv->onscreen, widget->style->black_gc, TRUE, 0, 0,
-			priv->width, priv->height);
-	mupoint_create_as_needed(&priv->mupoint,
-			priv->width, priv->height);
+			width, height);
 
 	g_object_ref_sink(priv->draw);
 	g_object_ref_sink(priv->onscreen);
 
+	priv->next.resize = true;
 	gfract_compute(widget);
 
 	return TRUE;
 }
 
-static gpointer run_worker(gpointer data)
+/* called from the rendering threads, which never take the gdk lock */
+static void worker_tick(void *data)
 {
-	GtkWidget *widget = data;
-	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(data);
+	g_atomic_int_inc(&priv->progress_done);
+	if (priv->checkpointing)
+		checkpoint_tick(&priv->checkpoint, &priv->fract);
+}
 
-	priv->stop_worker = false;
+/* Coarse passes go straight to the pixmap on screen, the final image
+ * replaces it as usual. A pass finishing before the last one was shown
+ * is skipped.
+ */
+static void worker_preview(void *data, unsigned step)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(data);
+	struct fract *f = &priv->fract;
 
-	unsigned ticks = priv->width / 16 + priv->width / 128;
+	if (g_atomic_int_get(&priv->preview_ready))
+		return;
 
-	if (priv->progress) {
-		gdk_threads_enter();
-		progress_start(widget, ticks);
-		gdk_threads_leave();
-	}
+	if (fract_colour_coarse(f, priv->preview_rgb, f->width * 3, step))
+		g_atomic_int_set(&priv->preview_ready, 1);
+}
 
-	do_mu(widget, 0, priv->width);
+/* Everything but the buffer work render_start() does, which is the part
+ * that can run away from the main loop.
+ */
+static gpointer run_worker(gpointer data)
+{
+	GtkWidget *widget = data;
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	struct fract *f = &priv->fract;
 
-	if (priv->stop_worker)
-		goto cleanup;
+	priv->worker_done = false;
 
-	if (priv->do_energy)
-		doenergy(widget);
-	priv->do_energy = false;
+	if (!fract_compute(f))
+		return data;
 
-	if (priv->stop_worker)
-		goto cleanup;
+	priv->worker_done = !f->stop && fract_colour(f, priv->rgb, f->width * 3);
 
-	draw(widget);
+	return data;
+}
 
-	if (priv->stop_worker)
-		goto cleanup;
+/* Called with the lock held, once the worker is gone */
+static void render_finish(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	struct fract *f = &priv->fract;
+
+	/* a single upload for the whole frame instead of one per pixel */
+	if (priv->worker_done && priv->worker_generation == priv->generation) {
+		GdkGC *gc = gdk_gc_new(priv->draw);
+		gdk_draw_rgb_image(priv->draw, gc, 0, 0, f->width, f->height,
+				GDK_RGB_DITHER_NONE, priv->rgb, f->width * 3);
+		g_object_unref(gc);
+
+		void *aux = priv->onscreen;
+		priv->onscreen = priv->draw;
+		priv->draw = aux;
+		priv->current = true;
+
+		if (priv->worker_store)
+			mucache_store(&priv->cache, f);
+	}
 
-	void *aux = priv->onscreen;
-	priv->onscreen = priv->draw;
-	priv->draw = aux;
+	/* a render cut short leaves what it finished for the next one */
+	if (priv->checkpointing) {
+		bool ok = f->rendered.valid
+			? checkpoint_finish(&priv->checkpoint, f)
+			: checkpoint_save(&priv->checkpoint, f);
+		if (!ok)
+			g_warning("Could not write '%s': %s",
+					priv->checkpoint_name, g_strerror(errno));
+		checkpoint_close(&priv->checkpoint);
+		priv->checkpointing = false;
+		f->tile = NULL;
+	}
 
-cleanup:
-	if (priv->progress) {
-		gdk_threads_enter();
+	if (priv->progress)
 		progress_finish(widget);
-		gdk_threads_leave();
-	}
 
-	gdk_threads_enter();
-	gdk_window_invalidate_rect(widget->window, NULL, TRUE);
-	gdk_threads_leave();
+	if (GTK_WIDGET_REALIZED(widget))
+		gdk_window_invalidate_rect(widget->window, NULL, TRUE);
 
-	return data;
+	if (priv->next.queued)
+		render_start(widget);
 }
 
-static void draw(GtkWidget *widget)
+static gboolean worker_finished(gpointer data)
 {
+	GtkWidget *widget = data;
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	struct mupoint *m = &priv->mupoint;
-	unsigned width = priv->width;
-	unsigned height = priv->height;
 
-	unsigned ticked = 0;
+	/* it has returned by now, or is just about to */
+	g_thread_join(priv->worker);
+	priv->worker = NULL;
 
 	gdk_threads_enter();
-	GdkGC *gc = gdk_gc_new(priv->draw);
+	render_finish(widget);
 	gdk_threads_leave();
 
-	long double avg;
-	if (priv->avgfactor.n > 0)
-		avg = priv->avgfactor.v / priv->avgfactor.n;
-	else
-		avg = 1;
-	long double energyfactor = do_energyfactor(avg, 0.2, 0.8) * 1000;
-
-	for (unsigned i = 0; i < width; i++) {
-		for (unsigned j = 0; j < height; j++) {
-			long double factor = m->mu[i][j] * energyfactor;
-			guint32 red = priv->ratios.red * factor;
-			guint32 blue = priv->ratios.blue * factor;
-			guint32 green = priv->ratios.green * factor;
-
-			static const guint16 cmax = ~0;
-
-			red = red > cmax ? cmax : red;
-			blue = blue > cmax ? cmax : blue;
-			green = green > cmax ? cmax : green;
-
-			gdk_threads_enter();
-			GdkColor color = { .red = red, .blue = blue, .green = green };
-			gdk_gc_set_rgb_fg_color(gc, &color);
-			gdk_draw_point(priv->draw, gc, i, j);
-			gdk_threads_leave();
-		}
-		if (priv->progress && (ticked++ & 127) == 0) {
-			if (priv->stop_worker)
-				return;
-			gdk_threads_enter();
-			progress_tick(widget);
-			gdk_threads_leave();
-		}
-	}
+	g_object_unref(widget);
+	return FALSE;
+}
 
-	gdk_threads_enter();
-	g_object_unref(gc);
-	gdk_threads_leave();
+static gpointer run_worker_thread(gpointer data)
+{
+	run_worker(data);
+	g_idle_add(worker_finished, data);
+	return data;
 }
 
-static void doenergy(GtkWidget *widget)
+/* Takes what the checkpoint file has of a full render about to start */
+static void checkpoint_start(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->avgfactor.v = 0L;
-	priv->avgfactor.n = 0;
-	unsigned width = priv->width;
-	unsigned height = priv->height;
-	for (unsigned i = 0; i < width; i++)
-		for (unsigned j = 0; j < height; j++) {
-			if (priv->mupoint.mu[i][j] == 0)
-				continue;
-			priv->avgfactor.v += priv->mupoint.mu[i][j];
-			priv->avgfactor.n++;
-		}
+
+	if (!priv->checkpoint_name)
+		return;
+
+	priv->checkpointing = checkpoint_open(&priv->checkpoint,
+			priv->checkpoint_name, &priv->fract);
+	if (!priv->checkpointing) {
+		g_warning("Could not open '%s': %s",
+				priv->checkpoint_name, g_strerror(errno));
+		return;
+	}
+
+	priv->fract.tile = checkpoint_tile;
+	priv->fract.tile_data = &priv->checkpoint;
 }
 
-static void do_mu(GtkWidget *widget, unsigned begin, size_t n)
+/* Only ever called from the main loop with no worker running */
+static void render_start(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	struct mupoint *m = &priv->mupoint;
-	unsigned height = priv->height;
-	long double x;
-	long double y;
-	long double acc = 0;
-	unsigned nacc = 0;
-	unsigned ticked = 0;
+	struct fract *f = &priv->fract;
 
-	x = priv->paint_limits.ulx + begin * paint_inc(widget);
-	for (unsigned i = 0; i < n; i++) {
-		y = priv->paint_limits.uly;
-		for (unsigned j = 0; j < height; j++) {
-			if (m->mu[i + begin][j] != -1L)
-				goto inc_and_cont;
-
-			long double modulus;
-			unsigned it = 0;
-			if (priv->type == GFRACT_MANDEL)
-				it = mandelbrot_it(priv->maxit, &x, &y, &modulus);
-			else if (priv->type == GFRACT_JULIA)
-				it = julia_it(priv->maxit, &x, &y,
-						&priv->cx, &priv->cy, &modulus);
-			else if (priv->type == GFRACT_BURNINGSHIP)
-				it = burningship_it(priv->maxit, &x, &y, &modulus);
-
-			/* Renormalized formula for the escape radius.
-			 * Optimize away the case where it == 0
-			 */
-			if (it > 0) {
-				long double mu = it - logl(fabsl(logl(modulus)));
-				mu /= M_LN2;
-				m->mu[i + begin][j] = mu < 0 ? 0 : mu;
-				acc += mu;
-				nacc++;
-			} else
-				m->mu[i + begin][j] = 0L;
-inc_and_cont:
-			y -= paint_inc(widget);
-		}
-		x += paint_inc(widget);
-		if (priv->progress && (ticked++ & 15) == 0) {
-			if (priv->stop_worker)
-				return;
-			gdk_threads_enter();
-			progress_tick(widget);
-			gdk_threads_leave();
+	if (priv->next.resize) {
+		priv->rgb = xrealloc(priv->rgb, f->width * f->height * 3);
+		priv->preview_rgb = xrealloc(priv->preview_rgb,
+				f->width * f->height * 3);
+		fract_set_size(f, f->width, f->height);
+	}
+
+	settings_apply(priv);
+	if (priv->next.set_view)
+		f->view = priv->next.view;
+	if (priv->next.dx > 0)
+		fract_move_right(f, priv->next.dx);
+	else if (priv->next.dx < 0)
+		fract_move_left(f, -priv->next.dx);
+	if (priv->next.dy > 0)
+		fract_move_down(f, priv->next.dy);
+	else if (priv->next.dy < 0)
+		fract_move_up(f, -priv->next.dy);
+
+	bool cached = false;
+	if (priv->next.compute) {
+		cached = mucache_restore(&priv->cache, f);
+		if (!cached && !fract_continue(f) && !fract_zoom(f)) {
+			fract_clean(f);
+			checkpoint_start(widget);
 		}
 	}
+	priv->worker_store = priv->next.compute && !cached;
+
+	memset(&priv->next, 0, sizeof(priv->next));
+	priv->worker_generation = priv->generation;
+
+	fract_begin(f);
+
+	/* all there is left to do is the colouring */
+	if (cached || (priv->checkpointing && priv->checkpoint.complete)) {
+		f->progress = NULL;
+		f->preview = NULL;
+		if (priv->progress)
+			progress_start(widget, 1);
+		priv->worker_done = fract_colour(f, priv->rgb, f->width * 3);
+		render_finish(widget);
+		return;
+	}
+
+	/* without a progress bar nothing is shown before we return */
+	if (!priv->progress) {
+		f->progress = priv->checkpointing ? worker_tick : NULL;
+		f->progress_data = widget;
+		f->preview = NULL;
+		run_worker(widget);
+		render_finish(widget);
+		return;
+	}
+
+	f->progress = worker_tick;
+	f->progress_data = widget;
+	f->preview = worker_preview;
+	f->preview_data = widget;
+	progress_start(widget, fract_ticks(f));
 
-	priv->avgfactor.v += acc;
-	priv->avgfactor.n += nacc;
+	/* let go in worker_finished() */
+	g_object_ref(widget);
+	priv->worker = g_thread_create(run_worker_thread, widget, TRUE, NULL);
 }
 
 void gfract_clear_history(GtkWidget *widget)
@@ -618,11 +779,47 @@ void gfract_clear_history(GtkWidget *widget)
 	priv->states = NULL;
 }
 
+void gfract_set_checkpoint(GtkWidget *widget, const gchar *filename)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	g_free(priv->checkpoint_name);
+	priv->checkpoint_name = g_strdup(filename);
+}
+
+const gchar *gfract_get_checkpoint(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->checkpoint_name;
+}
+
+void gfract_set_cache_budget(GtkWidget *widget, gsize budget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	mucache_set_budget(&priv->cache, budget);
+}
+
+gsize gfract_get_cache_budget(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->cache.budget;
+}
+
 void gfract_set_history(GtkWidget *widget, GSList *n)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
 	gfract_clear_history(widget);
-	priv->states = g_slist_copy(n);
+
+	/* Entries only come with the doubles, swap them for full ones.
+	 * They are ours either way, see gfract.h.
+	 */
+	for (; n; n = n->next) {
+		const struct fract_view *in = n->data;
+		struct fract_view *o = xmalloc(sizeof(*o));
+		fract_view_from_limits(o, in->ulx, in->uly, in->lly);
+		free(n->data);
+		priv->states = g_slist_prepend(priv->states, o);
+	}
+	priv->states = g_slist_reverse(priv->states);
 }
 
 GSList *gfract_get_history(GtkWidget *widget)
@@ -635,12 +832,14 @@ void gfract_get_limits(GtkWidget *widget,
 		gdouble *ulx, gdouble *uly, gdouble *lly)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	const struct fract_view *v = priv->next.set_view
+		? &priv->next.view : &priv->fract.view;
 	if (ulx)
-		*ulx = priv->paint_limits.ulx;
+		*ulx = v->ulx;
 	if (uly)
-		*uly = priv->paint_limits.uly;
+		*uly = v->uly;
 	if (lly)
-		*lly = priv->paint_limits.lly;
+		*lly = v->lly;
 }
 
 void gfract_set_limits_default(GtkWidget *widget)
@@ -654,45 +853,18 @@ void gfract_set_limits_default(GtkWidget *widget)
 void gfract_set_limits(GtkWidget *widget,
 		gdouble ulx, gdouble uly, gdouble lly)
 {
-	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->paint_limits.ulx = ulx;
-	priv->paint_limits.uly = uly;
-	priv->paint_limits.lly = lly;
-}
-
-static void box_limits(GtkWidget *widget,
-		unsigned sx, unsigned sy, unsigned dx, unsigned dy,
-		double *ulx, double *uly, double *lly)
-{
-	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	unsigned n_height = MAX(sy, dy) - MIN(sy, dy);
-	unsigned n_width = priv->width * n_height / priv->height;
-	if (dx < sx)
-		n_width = -n_width;
-
-	/* sx, sy, dx and dy are measured in pixels. thats why this
-	 * check is _so_ anti-intuitive
-	 */
-	unsigned nuy = MIN(sy, dy);
-	unsigned nly = MAX(sy, dy);
-	unsigned nux = MIN(sx + n_width, sx);
-
-	if (ulx)
-		*ulx = nux * paint_inc(widget) + priv->paint_limits.ulx;
-	if (lly)
-		*lly = -(nly * paint_inc(widget) - priv->paint_limits.uly);
-	if (uly)
-		*uly = -(nuy * paint_inc(widget) - priv->paint_limits.uly);
+	struct fract_view o;
+	fract_view_from_limits(&o, ulx, uly, lly);
+	set_view(widget, &o);
 }
 
 void gfract_set_limits_box(GtkWidget *widget,
 		guint sx, guint sy, guint dx, guint dy)
 {
-	double ulx;
-	double uly;
-	double lly;
-	box_limits(widget, sx, sy, dx, dy, &ulx, &uly, &lly);
-	gfract_set_limits(widget, ulx, uly, lly);
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	struct fract_view o;
+	fract_view_box(&priv->fract, sx, sy, dx, dy, &o);
+	set_view(widget, &o);
 }
 
 void gfract_draw_box(GtkWidget *widget,
@@ -700,7 +872,7 @@ void gfract_draw_box(GtkWidget *widget,
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
 	unsigned n_height = MAX(sy, dy) - MIN(sy, dy);
-	unsigned n_width = priv->width * n_height / priv->height;
+	unsigned n_width = priv->fract.width * n_height / priv->fract.height;
 
 	if (dx < sx)
 		n_width = -n_width;
@@ -742,12 +914,13 @@ void gfract_draw_orbit(GtkWidget *widget, long double x, long double y)
 
 	unsigned n;
 	struct orbit_point *o = NULL;
-	if (priv->type == GFRACT_MANDEL)
-		o = mandelbrot_orbit(priv->maxit, &x, &y, &n);
-	else if (priv->type == GFRACT_JULIA)
-		o = julia_orbit(priv->maxit, &x, &y, &priv->cx, &priv->cy, &n);
-	else if (priv->type == GFRACT_BURNINGSHIP)
-		o = burningship_orbit(priv->maxit, &x, &y, &n);
+	struct fract *f = &priv->fract;
+	if (f->type == FRACT_MANDELBROT)
+		o = mandelbrot_orbit(f->maxit, &x, &y, &n);
+	else if (f->type == FRACT_JULIA)
+		o = julia_orbit(f->maxit, &x, &y, &f->cx, &f->cy, &n);
+	else if (f->type == FRACT_BURNINGSHIP)
+		o = burningship_orbit(f->maxit, &x, &y, &n);
 
 	for (unsigned i = 0; i < n; i++) {
 		gint sx;
@@ -780,63 +953,146 @@ void gfract_draw_orbit_pixel(GtkWidget *widget, guint px, guint py)
 void gfract_move_up(GtkWidget *widget, guint n)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->paint_limits.uly += n * paint_inc(widget);
-	priv->paint_limits.lly += n * paint_inc(widget);
-	while (n--)
-		mupoint_move_up(&priv->mupoint);
-	priv->do_energy = true;
+	priv->next.dy -= n;
 }
 
 void gfract_move_down(GtkWidget *widget, guint n)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->paint_limits.uly -= n * paint_inc(widget);
-	priv->paint_limits.lly -= n * paint_inc(widget);
-	while (n--)
-		mupoint_move_down(&priv->mupoint);
-	priv->do_energy = true;
+	priv->next.dy += n;
 }
 
 void gfract_move_right(GtkWidget *widget, guint n)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->paint_limits.ulx += n * paint_inc(widget);
-	while (n--)
-		mupoint_move_right(&priv->mupoint);
-	priv->do_energy = true;
+	priv->next.dx += n;
 }
 
 void gfract_move_left(GtkWidget *widget, guint n)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->paint_limits.ulx -= n *paint_inc(widget);
-	while (n--)
-		mupoint_move_left(&priv->mupoint);
-	priv->do_energy = true;
+	priv->next.dx -= n;
 }
 
 GdkPixbuf *gfract_get_pixbuf(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
 	return gdk_pixbuf_get_from_drawable(NULL,
-			priv->onscreen, NULL, 0, 0, 0, 0, priv->width, priv->height);
+			priv->onscreen, NULL, 0, 0, 0, 0,
+			priv->fract.width, priv->fract.height);
 }
 
 void gfract_set_maxit(GtkWidget *widget, glong maxit)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
 	if (maxit <= 0)
-		priv->maxit = 10;
+		priv->set.maxit = 10;
 	else if (maxit > UINT_MAX)
-		priv->maxit = UINT_MAX;
+		priv->set.maxit = UINT_MAX;
 	else
-		priv->maxit = maxit;
+		priv->set.maxit = maxit;
 }
 
 guint gfract_get_maxit(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	return priv->maxit;
+	return priv->set.maxit;
+}
+
+void gfract_set_subdivide(GtkWidget *widget, gboolean subdivide)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.subdivide = subdivide;
+}
+
+gboolean gfract_get_subdivide(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.subdivide;
+}
+
+void gfract_set_progressive(GtkWidget *widget, gboolean progressive)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.coarse = progressive ? PROGRESSIVE_STEP : 1;
+}
+
+gboolean gfract_get_progressive(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.coarse > 1;
+}
+
+void gfract_set_resume(GtkWidget *widget, gboolean resume)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.resume = resume;
+}
+
+gboolean gfract_get_resume(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.resume;
+}
+
+void gfract_set_distance_fill(GtkWidget *widget, gboolean fill)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.distance_fill = fill;
+}
+
+gboolean gfract_get_distance_fill(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.distance_fill;
+}
+
+void gfract_set_colouring(GtkWidget *widget, enum fract_colouring c)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.colouring = c;
+}
+
+enum fract_colouring gfract_get_colouring(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.colouring;
+}
+
+void gfract_set_equalise(GtkWidget *widget, gboolean equalise)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.equalise = equalise;
+}
+
+gboolean gfract_get_equalise(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.equalise;
+}
+
+void gfract_set_snap_zoom(GtkWidget *widget, gboolean snap)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->snap_zoom = snap;
+}
+
+gboolean gfract_get_snap_zoom(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->snap_zoom;
+}
+
+void gfract_set_interior_checks(GtkWidget *widget, guint checks)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.interior_checks = checks;
+}
+
+guint gfract_get_interior_checks(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.interior_checks;
 }
 
 gboolean gfract_select_get_active(GtkWidget *widget)
@@ -854,34 +1110,25 @@ void gfract_select_set_active(GtkWidget *widget, gboolean active)
 void gfract_stop(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->stop_worker = true;
+	fract_stop(&priv->fract);
 
 	if (priv->states) {
-		struct observer_state *o = priv->states->data;
-		memcpy(&priv->paint_limits, o, sizeof(*o));
+		struct fract_view *o = priv->states->data;
+		set_view(widget, o);
 		priv->states = g_slist_remove(priv->states, o);
 		free(o);
 	}
 }
 
-void gfract_stop_wait(GtkWidget *widget)
-{
-	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	gfract_stop(widget);
-	if (priv->worker)
-		g_thread_join(priv->worker);
-	priv->worker = NULL;
-}
-
 void gfract_set_ratios(GtkWidget *widget, gfloat red, gfloat blue, gfloat green)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
 	if (red >= 0)
-		priv->ratios.red = red;
+		priv->set.red = red;
 	if (blue >= 0)
-		priv->ratios.blue = blue;
+		priv->set.blue = blue;
 	if (green >= 0)
-		priv->ratios.green = green;
+		priv->set.green = green;
 }
 
 void
@@ -889,18 +1136,41 @@ gfract_get_ratios(GtkWidget *widget, gfloat *red, gfloat *blue, gfloat *green)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
 	if (red)
-		*red = priv->ratios.red;
+		*red = priv->set.red;
 	if (blue)
-		*blue = priv->ratios.blue;
+		*blue = priv->set.blue;
 	if (green)
-		*green = priv->ratios.green;
+		*green = priv->set.green;
+}
+
+void gfract_set_gradient(GtkWidget *widget, const struct color_gradient *g)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	priv->set.gradient = g;
+}
+
+const struct color_gradient *gfract_get_gradient(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->set.gradient;
 }
 
 void gfract_set_center(GtkWidget *widget, long double x, long double y)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->cx = x;
-	priv->cy = y;
+	priv->set.cx = x;
+	priv->set.cy = y;
+}
+
+enum fract_precision gfract_get_precision(GtkWidget *widget)
+{
+	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
+	return priv->fract.precision;
+}
+
+const char *gfract_get_precision_name(GtkWidget *widget)
+{
+	return fract_precision_name(gfract_get_precision(widget));
 }
 
 void gfract_set_progress(GtkWidget *widget, GtkWidget *progress)
@@ -930,35 +1200,56 @@ gfract_set_progress_hook_finish(GtkWidget *widget,
 static void progress_start(GtkWidget *widget, unsigned ticks)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->progress_cur = 0;
-	priv->progress_stp = 1.0L / ticks;
-	gtk_widget_set_sensitive(widget, FALSE);
+	priv->progress_ticks = ticks;
+	g_atomic_int_set(&priv->progress_done, 0);
+	g_atomic_int_set(&priv->preview_ready, 0);
+	priv->progress_source = g_timeout_add(PROGRESS_INTERVAL,
+			progress_poll, widget);
 	if (priv->progress_hook_start)
 		(*priv->progress_hook_start)(priv->progress_hook_start_data);
 }
 
-static void progress_tick(GtkWidget *widget)
+static gboolean progress_poll(gpointer data)
 {
+	GtkWidget *widget = data;
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->progress_cur += priv->progress_stp;
-	if (priv->progress_cur > 1.0L)
-		return;
-	gchar *s = g_strdup_printf("Computing %u %%",
-			(unsigned)(priv->progress_cur * 100));
+	struct fract *f = &priv->fract;
+
+	gdk_threads_enter();
+
+	if (g_atomic_int_get(&priv->preview_ready)) {
+		GdkGC *gc = gdk_gc_new(priv->onscreen);
+		gdk_draw_rgb_image(priv->onscreen, gc, 0, 0, f->width, f->height,
+				GDK_RGB_DITHER_NONE, priv->preview_rgb,
+				f->width * 3);
+		g_object_unref(gc);
+		gdk_window_invalidate_rect(widget->window, NULL, TRUE);
+		g_atomic_int_set(&priv->preview_ready, 0);
+	}
+
+	unsigned done = g_atomic_int_get(&priv->progress_done);
+	if (done > priv->progress_ticks)
+		done = priv->progress_ticks;
+	double cur = (double)done / priv->progress_ticks;
+	gchar *s = g_strdup_printf("Computing %u %%", (unsigned)(cur * 100));
 	gtk_progress_bar_set_text(GTK_PROGRESS_BAR(priv->progress), s);
 	g_free(s);
-	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(priv->progress),
-			priv->progress_cur);
+	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(priv->progress), cur);
+
+	gdk_threads_leave();
+
+	return TRUE;
 }
 
 static void progress_finish(GtkWidget *widget)
 {
 	GFractMandelPrivate *priv = GFRACT_MANDEL_GET_PRIVATE(widget);
-	priv->progress_cur = 0;
-	priv->progress_stp = 0;
+	if (priv->progress_source)
+		g_source_remove(priv->progress_source);
+	priv->progress_source = 0;
+	priv->progress_ticks = 0;
 	gtk_progress_bar_set_text(GTK_PROGRESS_BAR(priv->progress), NULL);
 	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(priv->progress), 0.0L);
-	gtk_widget_set_sensitive(widget, TRUE);
 	if (priv->progress_hook_finish)
 		(*priv->progress_hook_finish)(priv->progress_hook_finish_data);
 }
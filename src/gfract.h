@@ -32,6 +32,8 @@
 #ifndef GMANDEL_GFRACT_H_
 #define GMANDEL_GFRACT_H_ 1
 
+#include "fract.h"
+
 G_BEGIN_DECLS
 
 #define GFRACT_TYPE_MANDEL (gfract_mandel_get_type())
@@ -86,13 +88,72 @@ void gfract_draw_box(GtkWidget *widget,
 
 void gfract_clean(GtkWidget *widget);
 
+/* History entries start with the ulx, uly and lly of a view as doubles,
+ * the most recent first. gfract_set_history() takes over the entries,
+ * which must come from malloc(), and leaves the list itself to the
+ * caller, as it always has. gfract_get_history() hands out a new list
+ * of the widget's own entries, which are not to be freed.
+ */
 void gfract_clear_history(GtkWidget *widget);
 void gfract_set_history(GtkWidget *widget, GSList *n);
 GSList *gfract_get_history(GtkWidget *widget);
 
+/* Full renders keep their finished tiles in this file as they go, and
+ * rendering the same view again, after a crash say, takes them from it
+ * instead of computing them. Each render starts the file over. NULL, the
+ * default, turns it off.
+ */
+void gfract_set_checkpoint(GtkWidget *widget, const gchar *filename);
+const gchar *gfract_get_checkpoint(GtkWidget *widget);
+
+/* Full renders are kept, up to this many bytes of them, so that going
+ * back to their views doesn't compute them again. 128MiB by default.
+ */
+void gfract_set_cache_budget(GtkWidget *widget, gsize budget);
+gsize gfract_get_cache_budget(GtkWidget *widget);
+
 void gfract_compute(GtkWidget *widget);
+/* Only computes what the moves since the last render exposed */
 void gfract_compute_partial(GtkWidget *widget);
 void gfract_redraw(GtkWidget *widget);
+/* After changing the colours, colours the finished render again */
+void gfract_recolour(GtkWidget *widget);
+
+/* Fill rectangles with a uniform border instead of iterating them */
+void gfract_set_subdivide(GtkWidget *widget, gboolean subdivide);
+gboolean gfract_get_subdivide(GtkWidget *widget);
+
+/* Show coarse versions of full renders while they refine, on by default */
+void gfract_set_progressive(GtkWidget *widget, gboolean progressive);
+gboolean gfract_get_progressive(GtkWidget *widget);
+
+/* Raising maxit and computing again carries on with the pixels that ran
+ * out of iterations instead of starting over, on by default.
+ */
+void gfract_set_resume(GtkWidget *widget, gboolean resume);
+gboolean gfract_get_resume(GtkWidget *widget);
+
+/* Subdivide tiles the distance estimate shows are far from the set */
+void gfract_set_distance_fill(GtkWidget *widget, gboolean fill);
+gboolean gfract_get_distance_fill(GtkWidget *widget);
+
+/* Takes a full render to show */
+void gfract_set_colouring(GtkWidget *widget, enum fract_colouring c);
+enum fract_colouring gfract_get_colouring(GtkWidget *widget);
+
+/* Spread the colours over the pixels on screen evenly, off by default */
+void gfract_set_equalise(GtkWidget *widget, gboolean equalise);
+gboolean gfract_get_equalise(GtkWidget *widget);
+
+/* Zoom selections round to the nearest integer factor of the view, so
+ * the pixels the two share need not be computed again. Off by default.
+ */
+void gfract_set_snap_zoom(GtkWidget *widget, gboolean snap);
+gboolean gfract_get_snap_zoom(GtkWidget *widget);
+
+/* checks is a mask of enum fract_interior */
+void gfract_set_interior_checks(GtkWidget *widget, guint checks);
+guint gfract_get_interior_checks(GtkWidget *widget);
 
 gboolean gfract_select_get_active(GtkWidget *widget);
 void gfract_select_set_active(GtkWidget *widget, gboolean active);
@@ -110,19 +171,25 @@ void gfract_move_left(GtkWidget *widget, guint n);
 GdkPixbuf *gfract_get_pixbuf(GtkWidget *widget);
 
 void gfract_stop(GtkWidget *widget);
-void gfract_stop_wait(GtkWidget *widget);
 
 void
 gfract_set_ratios(GtkWidget *widget, gfloat red, gfloat blue, gfloat green);
 void
 gfract_get_ratios(GtkWidget *widget, gfloat *red, gfloat *blue, gfloat *green);
 
+/* Takes over from the ratios unless NULL, which is the default */
+void gfract_set_gradient(GtkWidget *widget, const struct color_gradient *g);
+const struct color_gradient *gfract_get_gradient(GtkWidget *widget);
+
 void gfract_set_center(GtkWidget *widget, long double x, long double y);
 
 void gfract_pixel_to_point(GtkWidget *widget,
 		unsigned px, unsigned py,
 		long double *x, long double *y);
 
+enum fract_precision gfract_get_precision(GtkWidget *widget);
+const char *gfract_get_precision_name(GtkWidget *widget);
+
 void gfract_set_progress(GtkWidget *widget, GtkWidget *progress);
 
 void gfract_set_progress_hook_start(GtkWidget *widget,
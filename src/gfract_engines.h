@@ -32,9 +32,97 @@
 #ifndef GMANDEL_GFRACT_ENGINES_H_
 #define GMANDEL_GFRACT_ENGINES_H_ 1
 
+/* Quad precision kernels are only built where the compiler has it */
+#if defined(__SIZEOF_FLOAT128__)
+#    define GMANDEL_HAVE_FLOAT128 1
+typedef __float128 gmandel_float128;
+#endif
+
+#include <stdbool.h>
+
 struct orbit_point {
 	long double x;
 	long double y;
 };
 
+/* Where an orbit was left when it ran out of iterations, for the kernels
+ * taking one. it is what the kernel's counter was then, which is maxit,
+ * and 0 for orbits that escaped or were found inside. Calling the kernel
+ * again with a higher maxit carries on from there instead of from z_0.
+ */
+struct orbit_resume {
+	long double x;
+	long double y;
+	unsigned it;
+};
+
+/* The *_de_it kernels also carry the derivative of the orbit, and bail
+ * out past a much larger radius so that its distance estimate
+ * |z| log|z| / |dz| holds: the boundary of the set is no closer than
+ * half of it, nor farther than twice. It is 0 for points not escaping.
+ */
+#define DE_ESCAPE2 1e8L
+
+/* Early exits for points caught by an attracting cycle, for the kernels
+ * taking one (NULL disables both). The orbit counts as periodic when it
+ * comes back within eps of the point saved at the last power of two
+ * iteration (Brent), and as attracted when the squared derivative
+ * |dz_n/dz_0|^2 drops below deriv_eps. Either can be zero.
+ */
+struct interior_check {
+	long double eps;
+	long double deriv_eps;
+};
+
+struct interior_state {
+	long double eps2;
+	long double deriv_eps;
+	long double x;
+	long double y;
+	long double d2;
+	unsigned step;
+	unsigned lap;
+};
+
+static inline void interior_start(struct interior_state *s,
+		const struct interior_check *ic, long double x, long double y)
+{
+	s->eps2 = ic ? ic->eps * ic->eps : 0;
+	s->deriv_eps = ic ? ic->deriv_eps : 0;
+	s->x = x;
+	s->y = y;
+	s->d2 = 1;
+	s->step = 0;
+	s->lap = 1;
+}
+
+/* Called after every iteration, m2 is |z|^2 of the point iterated from.
+ * The derivative of z^2 + c and of the burning ship's fold alike scale
+ * |dz| by 2|z|.
+ */
+static inline bool interior_caught(struct interior_state *s,
+		long double x, long double y, long double m2)
+{
+	if (s->deriv_eps > 0) {
+		s->d2 *= 4 * m2;
+		if (s->d2 < s->deriv_eps)
+			return true;
+	}
+
+	if (s->eps2 > 0) {
+		long double dx = x - s->x;
+		long double dy = y - s->y;
+		if (dx * dx + dy * dy < s->eps2)
+			return true;
+		if (++s->step == s->lap) {
+			s->x = x;
+			s->y = y;
+			s->step = 0;
+			s->lap *= 2;
+		}
+	}
+
+	return false;
+}
+
 #endif
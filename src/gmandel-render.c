@@ -0,0 +1,289 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "color.h"
+#include "fract.h"
+#include "image.h"
+#include "state.h"
+#include "stream.h"
+#include "xfuncs.h"
+
+/* Renders a state file straight to an image, without a display */
+
+/* images with more pixels than this are rendered in bands by default */
+#define BAND_PIXELS (16 << 20)
+
+static void usage(FILE *f)
+{
+	fprintf(f, "Usage: gmandel-render [options] STATE OUTPUT\n"
+			"Renders the view in a gmandel state file to OUTPUT, a PPM\n"
+			"file when its name ends in .ppm and a PNG file otherwise.\n"
+			"\n"
+			"  -s WIDTHxHEIGHT  size of the image (default: 900x600)\n"
+			"  -t THEME         colour theme (default: iceblue)\n"
+			"  -j THREADS       rendering threads (default: one per CPU)\n"
+			"  -b ROWS          render and write ROWS rows at a time, to\n"
+			"                   keep the memory used down for large images\n"
+			"                   (default: as many as make %u pixels)\n"
+			"  -c FILE          keep the finished tiles in FILE as they\n"
+			"                   are done, and take those already there,\n"
+			"                   so a render cut short carries on\n"
+			"  -h               show this help\n"
+			"\n"
+			"Themes:", BAND_PIXELS);
+	for (char **n = color_get_names(); *n; n++)
+		fprintf(f, " %s", *n);
+	fprintf(f, "\n");
+}
+
+static bool parse_size(const char *s, unsigned *width, unsigned *height)
+{
+	char *end;
+	unsigned long w = strtoul(s, &end, 10);
+	if (end == s || *end != 'x')
+		return false;
+	s = end + 1;
+	unsigned long h = strtoul(s, &end, 10);
+	if (end == s || *end)
+		return false;
+	if (w == 0 || h == 0 || w > UINT_MAX || h > UINT_MAX)
+		return false;
+
+	*width = w;
+	*height = h;
+	return true;
+}
+
+static bool parse_theme(const char *s, enum COLOR_THEMES *theme)
+{
+	char **names = color_get_names();
+	for (unsigned i = 0; i < COLOR_THEME_LAST; i++)
+		if (strcmp(s, names[i]) == 0) {
+			*theme = i;
+			return true;
+		}
+	return false;
+}
+
+struct tick {
+	struct checkpoint *c;
+	const struct fract *f;
+};
+
+static void render_tick(void *data)
+{
+	struct tick *t = data;
+	checkpoint_tick(t->c, t->f);
+}
+
+static bool read_state(const char *filename, struct state *s)
+{
+	FILE *file = fopen(filename, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Could not open '%s': %s\n",
+				filename, strerror(errno));
+		return false;
+	}
+
+	char err[BUFSIZ];
+	bool ok = state_read(file, s, err, sizeof(err));
+	if (!ok)
+		fprintf(stderr, "Could not load '%s': %s\n", filename, err);
+
+	fclose(file);
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned width = 900;
+	unsigned height = 600;
+	unsigned nthreads = 0;
+	unsigned rows = 0;
+	const char *checkpoint = NULL;
+	enum COLOR_THEMES theme = COLOR_THEME_ICEBLUE;
+
+	int c;
+	while ((c = getopt(argc, argv, "s:t:j:b:c:h")) != -1) {
+		switch (c) {
+		case 's':
+			if (!parse_size(optarg, &width, &height)) {
+				fprintf(stderr, "Bad size '%s'\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 't':
+			if (!parse_theme(optarg, &theme)) {
+				fprintf(stderr, "Unknown theme '%s'\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'j': {
+			char *end;
+			unsigned long n = strtoul(optarg, &end, 10);
+			if (end == optarg || *end || n > UINT_MAX) {
+				fprintf(stderr, "Bad thread count '%s'\n", optarg);
+				return EXIT_FAILURE;
+			}
+			nthreads = n;
+			break;
+		}
+		case 'b': {
+			char *end;
+			unsigned long n = strtoul(optarg, &end, 10);
+			if (end == optarg || *end || n < 2 || n > UINT_MAX) {
+				fprintf(stderr, "Bad band height '%s'\n", optarg);
+				return EXIT_FAILURE;
+			}
+			rows = n;
+			break;
+		}
+		case 'c':
+			checkpoint = optarg;
+			break;
+		case 'h':
+			usage(stdout);
+			return EXIT_SUCCESS;
+		default:
+			usage(stderr);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind != 2) {
+		usage(stderr);
+		return EXIT_FAILURE;
+	}
+
+	const char *input = argv[optind];
+	const char *output = argv[optind + 1];
+
+	if (rows == 0)
+		rows = MAX(BAND_PIXELS / width, 2);
+
+	struct state s;
+	if (!read_state(input, &s))
+		return EXIT_FAILURE;
+
+	struct fract f;
+	fract_init(&f, FRACT_MANDELBROT, nthreads);
+	fract_view_from_limits(&f.view,
+			s.limits.ulx, s.limits.uly, s.limits.lly);
+	/* as gfract_set_maxit() takes it */
+	if (s.maxit == 0)
+		f.maxit = 10;
+	else
+		f.maxit = MIN(s.maxit, UINT_MAX);
+	f.ratios.red = color_get(theme)->red;
+	f.ratios.blue = color_get(theme)->blue;
+	f.ratios.green = color_get(theme)->green;
+	f.gradient = color_get_gradient(theme);
+	state_free(&s);
+
+	/* before rendering, not to find out it can't be written after */
+	struct image *img = image_open(output,
+			image_format_from_name(output), width, height);
+	if (!img) {
+		fprintf(stderr, "Could not write '%s': %s\n",
+				output, strerror(errno));
+		fract_destroy(&f);
+		return EXIT_FAILURE;
+	}
+
+	bool ok;
+	if (rows < height) {
+		bool failed;
+		ok = stream_render(&f, width, height, rows, img,
+				checkpoint, &failed);
+		if (!ok && failed) {
+			fprintf(stderr, "Could not write '%s': %s\n",
+					checkpoint, strerror(errno));
+			image_close(img);
+			fract_destroy(&f);
+			return EXIT_FAILURE;
+		}
+	} else {
+		size_t stride = 3 * (size_t)width;
+		unsigned char *rgb = xmalloc(stride * height);
+
+		fract_set_size(&f, width, height);
+		fract_clean(&f);
+
+		struct checkpoint cp;
+		struct tick t = { .c = &cp, .f = &f };
+		ok = !checkpoint || checkpoint_open(&cp, checkpoint, &f);
+		if (!ok)
+			fprintf(stderr, "Could not open '%s': %s\n",
+					checkpoint, strerror(errno));
+		else if (checkpoint) {
+			f.progress = render_tick;
+			f.progress_data = &t;
+			f.tile = checkpoint_tile;
+			f.tile_data = &cp;
+		}
+
+		if (ok && (!checkpoint || !cp.complete)) {
+			fract_begin(&f);
+			fract_compute(&f);
+		}
+
+		if (ok && checkpoint) {
+			if (!checkpoint_finish(&cp, &f))
+				fprintf(stderr, "Could not write '%s': %s\n",
+						checkpoint, strerror(errno));
+			checkpoint_close(&cp);
+			f.tile = NULL;
+		}
+
+		if (ok) {
+			fract_colour(&f, rgb, stride);
+			ok = image_write_rows(img, rgb, stride, height);
+		}
+		free(rgb);
+	}
+	fract_destroy(&f);
+
+	ok = image_close(img) && ok;
+	if (!ok)
+		fprintf(stderr, "Could not write '%s': %s\n",
+				output, strerror(errno));
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
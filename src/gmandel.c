@@ -46,14 +46,17 @@
 
 #include "gfract.h"
 
-static void set_sensitive(gpointer data)
+static void render_started(gpointer data)
 {
-	gtk_widget_set_sensitive(data, TRUE);
+	struct gui_params *gui = data;
+	gtk_widget_set_sensitive(gui->stop, TRUE);
+	gui_status_set_precision(gfract_get_precision_name(gui->fract));
 }
 
-static void set_insensitive(gpointer data)
+static void render_finished(gpointer data)
 {
-	gtk_widget_set_sensitive(data, FALSE);
+	struct gui_params *gui = data;
+	gtk_widget_set_sensitive(gui->stop, FALSE);
 }
 
 int main(int argc, char *argv[])
@@ -71,6 +74,7 @@ int main(int argc, char *argv[])
 	struct gui_params gui_state = {
 		.window = NULL,
 		.fract = NULL,
+		.stop = NULL,
 	};
 
 	g_thread_init(NULL);
@@ -103,18 +107,18 @@ int main(int argc, char *argv[])
 
 	GtkWidget *progbox = gtk_hbox_new(FALSE, 0);
 	GtkWidget *prog = gtk_progress_bar_new();
-	GtkWidget *stopb = gtk_button_new_from_stock(GTK_STOCK_STOP);
-	g_signal_connect_swapped(stopb, "clicked",
+	gui_state.stop = gtk_button_new_from_stock(GTK_STOCK_STOP);
+	g_signal_connect_swapped(gui_state.stop, "clicked",
 			G_CALLBACK(gfract_stop), gui_state.fract);
 	gtk_container_add(GTK_CONTAINER(progbox), prog);
-	gtk_box_pack_start(GTK_BOX(progbox), stopb, FALSE, FALSE, 0);
+	gtk_box_pack_start(GTK_BOX(progbox), gui_state.stop, FALSE, FALSE, 0);
 	gtk_container_add(GTK_CONTAINER(layout), progbox);
 
 	gfract_set_progress(gui_state.fract, prog);
 	gfract_set_progress_hook_start(gui_state.fract,
-			set_sensitive, stopb);
+			render_started, &gui_state);
 	gfract_set_progress_hook_finish(gui_state.fract,
-			set_insensitive, stopb);
+			render_finished, &gui_state);
 
 	gtk_container_add(GTK_CONTAINER(layout), gui_state.fract);
 	gtk_container_add(GTK_CONTAINER(layout), gui_status_build());
@@ -39,6 +39,7 @@
 struct gui_params {
 	GtkWidget *window;
 	GtkWidget *fract;
+	GtkWidget *stop;
 };
 
 #endif
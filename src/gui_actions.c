@@ -29,6 +29,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <errno.h>
 #include <string.h>
 
 #include <gtk/gtk.h>
@@ -81,6 +82,78 @@ void toggle_orbits(GtkToggleAction *action, gpointer data)
 			!gfract_orbits_get_active(gui->fract));
 }
 
+void toggle_subdivide(GtkToggleAction *action, gpointer data)
+{
+	struct gui_params *gui = data;
+	gfract_set_subdivide(gui->fract,
+			gtk_toggle_action_get_active(action));
+}
+
+void toggle_progressive(GtkToggleAction *action, gpointer data)
+{
+	struct gui_params *gui = data;
+	gfract_set_progressive(gui->fract,
+			gtk_toggle_action_get_active(action));
+}
+
+void toggle_snap_zoom(GtkToggleAction *action, gpointer data)
+{
+	struct gui_params *gui = data;
+	gfract_set_snap_zoom(gui->fract,
+			gtk_toggle_action_get_active(action));
+}
+
+/* Where renders are checkpointed to: gmandel/gmandel.checkpoint in the
+ * user's cache directory, ~/.cache unless XDG_CACHE_HOME says otherwise
+ */
+static gchar *checkpoint_file(void)
+{
+	gchar *dir = g_build_filename(g_get_user_cache_dir(), "gmandel", NULL);
+	if (g_mkdir_with_parents(dir, 0700) != 0)
+		g_warning("Could not create '%s': %s", dir, g_strerror(errno));
+
+	gchar *file = g_build_filename(dir, "gmandel.checkpoint", NULL);
+	g_free(dir);
+	return file;
+}
+
+void toggle_checkpoint(GtkToggleAction *action, gpointer data)
+{
+	struct gui_params *gui = data;
+
+	if (!gtk_toggle_action_get_active(action)) {
+		gfract_set_checkpoint(gui->fract, NULL);
+		return;
+	}
+
+	gchar *file = checkpoint_file();
+	gfract_set_checkpoint(gui->fract, file);
+	g_free(file);
+}
+
+void toggle_distance_fill(GtkToggleAction *action, gpointer data)
+{
+	struct gui_params *gui = data;
+	gfract_set_distance_fill(gui->fract,
+			gtk_toggle_action_get_active(action));
+}
+
+void toggle_distance_colouring(GtkToggleAction *action, gpointer data)
+{
+	struct gui_params *gui = data;
+	gfract_set_colouring(gui->fract,
+			gtk_toggle_action_get_active(action)
+			? FRACT_COLOUR_DISTANCE : FRACT_COLOUR_ITERATIONS);
+	gfract_compute(gui->fract);
+}
+
+void toggle_equalise(GtkToggleAction *action, gpointer data)
+{
+	struct gui_params *gui = data;
+	gfract_set_equalise(gui->fract, gtk_toggle_action_get_active(action));
+	gfract_recolour(gui->fract);
+}
+
 void theme_changed(
 		GtkRadioAction *action, GtkRadioAction *current, gpointer data)
 {
@@ -88,12 +161,14 @@ void theme_changed(
 	const char *name = gtk_action_get_name(GTK_ACTION(current));
 	char **names = color_get_names();
 	for (unsigned i = 0; i < COLOR_THEME_LAST; i++)
-		if (strcmp(name, names[i]) == 0)
+		if (strcmp(name, names[i]) == 0) {
 			gfract_set_ratios(gui->fract,
 					color_get(i)->red,
 					color_get(i)->blue,
 					color_get(i)->green);
-	gfract_redraw(gui->fract);
+			gfract_set_gradient(gui->fract, color_get_gradient(i));
+		}
+	gfract_recolour(gui->fract);
 }
 
 void handle_about(GtkAction *action, gpointer data)
@@ -39,6 +39,13 @@ void handle_loadstate(GtkAction *action, gpointer data);
 void handle_save(GtkAction *action, gpointer data);
 void handle_recompute(GtkAction *action, gpointer data);
 void toggle_orbits(GtkToggleAction *action, gpointer data);
+void toggle_subdivide(GtkToggleAction *action, gpointer data);
+void toggle_progressive(GtkToggleAction *action, gpointer data);
+void toggle_snap_zoom(GtkToggleAction *action, gpointer data);
+void toggle_checkpoint(GtkToggleAction *action, gpointer data);
+void toggle_distance_fill(GtkToggleAction *action, gpointer data);
+void toggle_distance_colouring(GtkToggleAction *action, gpointer data);
+void toggle_equalise(GtkToggleAction *action, gpointer data);
 void theme_changed(
 		GtkRadioAction *action, GtkRadioAction *current, gpointer data);
 void handle_about(GtkAction *action, gpointer data);
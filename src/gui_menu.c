@@ -73,6 +73,29 @@ GtkWidget *gui_menu_build(GtkWidget *window, gpointer data)
 		{ "Orbits", NULL, "_Orbits",
 			"<alt>O", "Activate / Deactivate mandelbrot orbits",
 			G_CALLBACK(toggle_orbits), FALSE },
+		{ "Subdivide", NULL, "_Subdivide",
+			NULL, "Fill uniform rectangles without iterating them",
+			G_CALLBACK(toggle_subdivide), FALSE },
+		{ "Progressive", NULL, "_Progressive",
+			NULL, "Show coarse previews while computing",
+			G_CALLBACK(toggle_progressive), TRUE },
+		{ "SnapZoom", NULL, "Snap _zoom",
+			NULL, "Zoom by whole factors, reusing the pixels already computed",
+			G_CALLBACK(toggle_snap_zoom), FALSE },
+		{ "Checkpoint", NULL, "_Checkpoint",
+			NULL, "Keep finished tiles in gmandel/gmandel.checkpoint "
+				"under the cache directory, ~/.cache by default, "
+				"to survive crashes",
+			G_CALLBACK(toggle_checkpoint), FALSE },
+		{ "DistanceFill", NULL, "_Distance fill",
+			NULL, "Skip tiles far from the set by their distance estimate",
+			G_CALLBACK(toggle_distance_fill), FALSE },
+		{ "DistanceColour", NULL, "By _distance",
+			NULL, "Colour by the distance to the set",
+			G_CALLBACK(toggle_distance_colouring), FALSE },
+		{ "Equalise", NULL, "_Equalise",
+			NULL, "Spread the colours evenly over the pixels on screen",
+			G_CALLBACK(toggle_equalise), FALSE },
 	};
 
 	static GtkRadioActionEntry radio_entries[COLOR_THEME_LAST];
@@ -100,8 +123,16 @@ GtkWidget *gui_menu_build(GtkWidget *window, gpointer data)
 		"      <menuitem action='Restart' />"
 		"      <menuitem action='Recompute'/>"
 		"      <menuitem action='Orbits'/>"
+		"      <menuitem action='Subdivide'/>"
+		"      <menuitem action='Progressive'/>"
+		"      <menuitem action='SnapZoom'/>"
+		"      <menuitem action='Checkpoint'/>"
+		"      <menuitem action='DistanceFill'/>"
 		"    </menu>"
-		"    <menu action='ColorMenu'>";
+		"    <menu action='ColorMenu'>"
+		"      <menuitem action='DistanceColour'/>"
+		"      <menuitem action='Equalise'/>"
+		"      <separator/>";
 
 	gchar *themes_menu_desc = g_strdup("");
 	for (unsigned i = 0; i < G_N_ELEMENTS(radio_entries); i++) {
@@ -40,6 +40,7 @@
 #include "gui_report.h"
 #include "gui_status.h"
 #include "gfract.h"
+#include "state.h"
 #include "xfuncs.h"
 
 struct observer_state {
@@ -48,169 +49,29 @@ struct observer_state {
 	double lly;
 };
 
-static void gmandel_stripnl(char *s)
+static void load_state(struct gui_params *gui, const struct state *s)
 {
-	for (; s && *s; s++)
-		if (*s == '\n')
-			*s = '\0';
-}
-
-static bool gmandel_fgets(GtkWidget *window, char *buf, int n, FILE *file)
-{
-	if (fgets(buf, n, file) != NULL) {
-		gmandel_stripnl(buf);
-		return true;
-	}
-
-	if (feof(file))
-		gui_report_error(window, "Unexpected EOF");
-	else if (ferror(file))
-		gui_report_error(window, "Unexpected error");
-
-	return false;
-}
-
-static bool gmandel_strtoul(
-		GtkWidget *window, const char *var,
-		const char *nptr, unsigned long *value)
-{
-	bool err = false;
-	char *del = strrchr(nptr, '\n');
-	if (del)
-		*del = '\0';
-	char *endptr;
-	errno = 0;
-	unsigned long n = strtoul(nptr, &endptr, 10);
-	if (endptr == nptr || *endptr) {
-		gui_report_error(window, "Could not get a sane value for %s", var);
-		err = true;
-	} else if (errno) {
-		gui_report_error(window, "Could not get a sane value for %s: %s",
-				var, g_strerror(errno));
-		err = true;
-	}
-
-	*value = n;
-	return !err;
-}
-
-static bool gmandel_strtod(
-		GtkWidget *window, const char *var,
-		const char *nptr, double *value)
-{
-	bool err = false;
-	char *del = strrchr(nptr, '\n');
-	if (del)
-		*del = '\0';
-	char *endptr;
-	errno = 0;
-	double num = strtod(nptr, &endptr);
-	if (endptr == nptr || *endptr) {
-		gui_report_error(window, "Could not get a sane value for %s", var);
-		err = true;
-	} else if (errno) {
-		gui_report_error(window, "Could not get a sane value for %s: %s",
-				var, g_strerror(errno));
-		err = true;
-	}
-
-	*value = num;
-	return !err;
-}
-
-static bool loader_1(struct gui_params *gui, FILE *file)
-{
-	char buf[BUFSIZ];
-	unsigned long maxit;
-	double ulx;
-	double uly;
-	double lly;
-
-	if (!gmandel_fgets(gui->window, buf, sizeof(buf), file))
-		return false;
-	else if (!gmandel_strtoul(gui->window, "maxit", buf, &maxit))
-		return false;
-
-#define READ_VAR_DOUBLE(a) do { \
-	if (!gmandel_fgets(gui->window, buf, sizeof(buf), file)) \
-		return false; \
-	else if (!gmandel_strtod(gui->window, #a, buf, &(a))) \
-		return false; \
-} while (0);
-
-	READ_VAR_DOUBLE(ulx);
-	READ_VAR_DOUBLE(uly);
-	READ_VAR_DOUBLE(lly);
-
-#undef READ_VAR_DOUBLE
-
-	gfract_set_maxit(gui->fract, maxit);
-	gfract_set_limits(gui->fract, ulx, uly, lly);
+	gfract_set_maxit(gui->fract, s->maxit);
+	gfract_set_limits(gui->fract,
+			s->limits.ulx, s->limits.uly, s->limits.lly);
 
 	gfract_clear_history(gui->fract);
-
-	return true;
-}
-
-static bool loader_2(struct gui_params *gui, FILE *file)
-{
-	if (!loader_1(gui, file))
-		return false;
-
-	char buf[BUFSIZ];
-
-	unsigned long num_elem;
-	if (!gmandel_fgets(gui->window, buf, sizeof(buf), file))
-		return false;
-	else if (!gmandel_strtoul(gui->window, "num_elem", buf, &num_elem))
-		return false;
+	if (!s->history)
+		return;
 
 	GSList *nh = NULL;
-
-#define READ_VAR_DOUBLE(a) do { \
-	if (!gmandel_fgets(gui->window, buf, sizeof(buf), file)) \
-		return false; \
-	else if (!gmandel_strtod(gui->window, #a, buf, &(a))) \
-		return false; \
-} while (0);
-
-	while (num_elem--) {
+	for (unsigned long i = 0; i < s->nhistory; i++) {
 		struct observer_state *o = xmalloc(sizeof(*o));
-		READ_VAR_DOUBLE(o->ulx);
-		READ_VAR_DOUBLE(o->uly);
-		READ_VAR_DOUBLE(o->lly);
+		o->ulx = s->history[i].ulx;
+		o->uly = s->history[i].uly;
+		o->lly = s->history[i].lly;
 		nh = g_slist_prepend(nh, o);
 	}
 
-#undef READ_VAR_DOUBLE
-
 	gfract_set_history(gui->fract, nh);
 	g_slist_free(nh);
-
-	return true;
 }
 
-enum {
-	GMANDEL_STATE_0 = 0, /* old, unsupported, format */
-	GMANDEL_STATE_1,
-	GMANDEL_STATE_2,
-	GMANDEL_STATE_CURRENT = GMANDEL_STATE_2,
-	GMANDEL_STATE_LAST,
-};
-
-static const char *format_strings[] = {
-	[GMANDEL_STATE_1] = "gmandel-1",
-	[GMANDEL_STATE_2] = "gmandel-2",
-	[GMANDEL_STATE_LAST] = NULL,
-};
-
-static bool (*format_loaders[])(struct gui_params *, FILE *) = {
-	[GMANDEL_STATE_0] = NULL,
-	[GMANDEL_STATE_1] = loader_1,
-	[GMANDEL_STATE_2] = loader_2,
-	[GMANDEL_STATE_LAST] = NULL,
-};
-
 bool gui_state_load(struct gui_params *gui)
 {
 	char *filename = NULL;
@@ -236,27 +97,15 @@ bool gui_state_load(struct gui_params *gui)
 		goto cleanup;
 	}
 
-	char buf[BUFSIZ];
-	if (!gmandel_fgets(gui->window, buf, sizeof(buf), file)) {
-		err = true;
-		goto bad_file;
-	}
-
-	gmandel_stripnl(buf);
-
-	bool found = false;
-	for (unsigned i = GMANDEL_STATE_CURRENT; i > GMANDEL_STATE_0; i--) {
-		if (strcmp(buf, format_strings[i]) != 0)
-			continue;
-		found = true;
-		err = !(*format_loaders[i])(gui, file);
-		break;
-	}
+	struct state s;
+	char msg[BUFSIZ];
+	if (state_read(file, &s, msg, sizeof(msg))) {
+		load_state(gui, &s);
+		state_free(&s);
+		err = false;
+	} else
+		gui_report_error(gui->window, "%s", msg);
 
-	if (!found)
-		gui_report_error(gui->window, "Unsupported format");
-
-bad_file:
 	fclose(file);
 	if (err)
 		gui_status_set("Error while loading current state from %s", filename);
@@ -268,11 +117,6 @@ cleanup:
 	return !err;
 }
 
-void write_hist_entry(struct observer_state *o, FILE *f)
-{
-	fprintf(f, "%a\n%a\n%a\n", o->ulx, o->uly, o->lly);
-}
-
 bool gui_state_save(struct gui_params *gui)
 {
 	char *filename = NULL;
@@ -301,17 +145,25 @@ bool gui_state_save(struct gui_params *gui)
 		goto cleanup;
 	}
 
-	fprintf(file, "%s\n", format_strings[GMANDEL_STATE_CURRENT]);
-
-	unsigned int maxit = gfract_get_maxit(gui->fract);
-	double ulx, uly, lly;
-	gfract_get_limits(gui->fract, &ulx, &uly, &lly);
-	fprintf(file, "%d\n%a\n%a\n%a\n", maxit, ulx, uly, lly);
+	struct state s;
+	s.maxit = gfract_get_maxit(gui->fract);
+	gfract_get_limits(gui->fract,
+			&s.limits.ulx, &s.limits.uly, &s.limits.lly);
 
 	GSList *hist = g_slist_reverse(gfract_get_history(gui->fract));
-	guint n = g_slist_length(hist);
-	fprintf(file, "%u\n", n);
-	g_slist_foreach(hist, (GFunc)write_hist_entry, file);
+	s.nhistory = g_slist_length(hist);
+	s.history = xmalloc(s.nhistory * sizeof(*s.history));
+	unsigned long i = 0;
+	for (GSList *n = hist; n; n = n->next, i++) {
+		const struct observer_state *o = n->data;
+		s.history[i].ulx = o->ulx;
+		s.history[i].uly = o->uly;
+		s.history[i].lly = o->lly;
+	}
+	g_slist_free(hist);
+
+	state_write(file, &s);
+	state_free(&s);
 
 	fclose(file);
 
@@ -37,12 +37,15 @@
 
 static GtkWidget *statusbar;
 static guint context;
+static GtkWidget *precision;
 
 GtkWidget *gui_status_build(void)
 {
 	statusbar = gtk_statusbar_new();
 	gtk_statusbar_set_has_resize_grip(GTK_STATUSBAR(statusbar), FALSE);
 	context = gtk_statusbar_get_context_id(GTK_STATUSBAR(statusbar), "info");
+	precision = gtk_label_new(NULL);
+	gtk_box_pack_end(GTK_BOX(statusbar), precision, FALSE, FALSE, 4);
 	return statusbar;
 }
 
@@ -61,3 +64,10 @@ void gui_status_pop(void)
 {
 	gtk_statusbar_pop(GTK_STATUSBAR(statusbar), context);
 }
+
+void gui_status_set_precision(const gchar *name)
+{
+	gchar *text = g_strdup_printf("precision: %s", name);
+	gtk_label_set_text(GTK_LABEL(precision), text);
+	g_free(text);
+}
@@ -35,5 +35,6 @@
 GtkWidget *gui_status_build(void);
 void gui_status_set(const gchar *fmt, ...);
 void gui_status_pop(void);
+void gui_status_set_precision(const gchar *name);
 
 #endif
@@ -0,0 +1,250 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include <zlib.h>
+
+#include "image.h"
+#include "xfuncs.h"
+
+/* compressed bytes written as one IDAT chunk */
+#define PNG_CHUNK (64 << 10)
+
+struct image {
+	FILE *file;
+	enum image_format format;
+	unsigned width;
+	unsigned height;
+	unsigned row;
+	bool failed;
+	/* PNG only, rows go through the Sub filter into line */
+	z_stream z;
+	unsigned char *line;
+	unsigned char *out;
+};
+
+enum image_format image_format_from_name(const char *filename)
+{
+	const char *ext = strrchr(filename, '.');
+	if (ext && strcmp(ext, ".ppm") == 0)
+		return IMAGE_FORMAT_PPM;
+	return IMAGE_FORMAT_PNG;
+}
+
+static void put_be32(unsigned char *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static void png_chunk(struct image *img, const char *type,
+		const unsigned char *data, size_t len)
+{
+	unsigned char buf[4];
+	uLong crc = crc32(0, (const Bytef *)type, 4);
+	/* crc32() takes a NULL buffer as asking for its initial value */
+	if (len)
+		crc = crc32(crc, data, len);
+
+	put_be32(buf, len);
+	fwrite(buf, 1, 4, img->file);
+	fwrite(type, 1, 4, img->file);
+	fwrite(data, 1, len, img->file);
+	put_be32(buf, crc);
+	if (fwrite(buf, 1, 4, img->file) != 4)
+		img->failed = true;
+}
+
+/* Compresses what is in z's input, writing out every full chunk, and all
+ * of it for Z_FINISH
+ */
+static bool png_deflate(struct image *img, int flush)
+{
+	for (;;) {
+		int ret = deflate(&img->z, flush);
+		if (ret == Z_STREAM_ERROR) {
+			errno = EIO;
+			return false;
+		}
+
+		size_t have = PNG_CHUNK - img->z.avail_out;
+		if (img->z.avail_out == 0 || (flush == Z_FINISH && have)) {
+			png_chunk(img, "IDAT", img->out, have);
+			img->z.next_out = img->out;
+			img->z.avail_out = PNG_CHUNK;
+		}
+
+		if (flush == Z_FINISH ? ret == Z_STREAM_END : img->z.avail_in == 0)
+			return !img->failed;
+	}
+}
+
+static bool png_start(struct image *img)
+{
+	static const unsigned char signature[] = {
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n',
+	};
+	unsigned char ihdr[13];
+
+	put_be32(ihdr, img->width);
+	put_be32(ihdr + 4, img->height);
+	ihdr[8] = 8;	/* bits per channel */
+	ihdr[9] = 2;	/* RGB */
+	ihdr[10] = 0;	/* deflate */
+	ihdr[11] = 0;	/* adaptive filtering */
+	ihdr[12] = 0;	/* not interlaced */
+
+	fwrite(signature, 1, sizeof(signature), img->file);
+	png_chunk(img, "IHDR", ihdr, sizeof(ihdr));
+
+	memset(&img->z, 0, sizeof(img->z));
+	if (deflateInit(&img->z, Z_DEFAULT_COMPRESSION) != Z_OK) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	img->line = xmalloc(1 + 3 * (size_t)img->width);
+	img->out = xmalloc(PNG_CHUNK);
+	img->z.next_out = img->out;
+	img->z.avail_out = PNG_CHUNK;
+
+	return !img->failed;
+}
+
+struct image *image_open(const char *filename, enum image_format format,
+		unsigned width, unsigned height)
+{
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return NULL;
+
+	struct image *img = xmalloc(sizeof(*img));
+	img->file = file;
+	img->format = format;
+	img->width = width;
+	img->height = height;
+	img->row = 0;
+	img->failed = false;
+	img->line = NULL;
+	img->out = NULL;
+
+	bool ok;
+	if (format == IMAGE_FORMAT_PPM)
+		ok = fprintf(file, "P6\n%u %u\n255\n", width, height) > 0;
+	else
+		ok = png_start(img);
+
+	if (!ok) {
+		int e = errno;
+		if (format == IMAGE_FORMAT_PNG && img->out)
+			deflateEnd(&img->z);
+		free(img->line);
+		free(img->out);
+		free(img);
+		fclose(file);
+		errno = e;
+		return NULL;
+	}
+
+	return img;
+}
+
+bool image_write_rows(struct image *img,
+		const unsigned char *rgb, size_t stride, unsigned rows)
+{
+	if (img->failed || rows > img->height - img->row) {
+		errno = EINVAL;
+		return false;
+	}
+
+	size_t len = 3 * (size_t)img->width;
+
+	for (unsigned j = 0; j < rows; j++, rgb += stride) {
+		if (img->format == IMAGE_FORMAT_PPM) {
+			if (fwrite(rgb, 1, len, img->file) != len)
+				img->failed = true;
+			continue;
+		}
+
+		/* Sub: each byte as the difference from the one a pixel
+		 * to its left, which smooth colouring makes mostly small
+		 */
+		img->line[0] = 1;
+		memcpy(img->line + 1, rgb, MIN(len, 3));
+		for (size_t k = 3; k < len; k++)
+			img->line[1 + k] = rgb[k] - rgb[k - 3];
+
+		img->z.next_in = img->line;
+		img->z.avail_in = 1 + len;
+		if (!png_deflate(img, Z_NO_FLUSH))
+			img->failed = true;
+	}
+
+	img->row += rows;
+	return !img->failed;
+}
+
+bool image_close(struct image *img)
+{
+	bool ok = !img->failed && img->row == img->height;
+	int e = img->failed ? EIO : EINVAL;
+
+	if (img->format == IMAGE_FORMAT_PNG) {
+		if (ok) {
+			img->z.next_in = NULL;
+			img->z.avail_in = 0;
+			ok = png_deflate(img, Z_FINISH);
+			png_chunk(img, "IEND", NULL, 0);
+			ok = ok && !img->failed;
+		}
+		deflateEnd(&img->z);
+	}
+
+	if (fclose(img->file) != 0 && ok) {
+		ok = false;
+		e = errno;
+	}
+
+	free(img->line);
+	free(img->out);
+	free(img);
+
+	if (!ok)
+		errno = e;
+	return ok;
+}
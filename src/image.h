@@ -0,0 +1,59 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_IMAGE_H_
+#define GMANDEL_IMAGE_H_ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Writes 8 bit RGB images a few rows at a time, so that nothing but the
+ * rows being written needs to be in memory. Errors leave errno set.
+ */
+enum image_format {
+	IMAGE_FORMAT_PNG = 0,
+	IMAGE_FORMAT_PPM,
+};
+
+struct image;
+
+/* PPM for names ending in .ppm, PNG for anything else */
+enum image_format image_format_from_name(const char *filename);
+
+struct image *image_open(const char *filename, enum image_format format,
+		unsigned width, unsigned height);
+/* The next rows of the image, stride bytes apart in rgb */
+bool image_write_rows(struct image *img,
+		const unsigned char *rgb, size_t stride, unsigned rows);
+/* Finishes the file, which fails if not all rows were written */
+bool image_close(struct image *img);
+
+#endif
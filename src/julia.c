@@ -82,6 +82,7 @@ unsigned julia_it(
 		unsigned maxit,
 		long double *x_0, long double *y_0,
 		long double *cx, long double *cy,
+		struct orbit_resume *r,
 		long double *modulus)
 {
 	unsigned it = 1;
@@ -102,6 +103,15 @@ unsigned julia_it(
 	x2 = x * x;
 	y2 = y * y;
 
+	if (r && r->it) {
+		x = r->x;
+		y = r->y;
+		x2 = x * x;
+		y2 = y * y;
+		it = r->it;
+		r->it = 0;
+	}
+
 	while ((x2 + y2) < 16 && it++ < maxit) {
 		y = 2 * x * y + yc;
 		x = x2 - y2 + xc;
@@ -109,8 +119,14 @@ unsigned julia_it(
 		y2 = y * y;
 	}
 
-	if (it >= maxit)
+	if (it >= maxit) {
+		if (r) {
+			r->x = x;
+			r->y = y;
+			r->it = maxit;
+		}
 		return 0;
+	}
 
 	/* When using the renormalized formula for the escape radius,
 	 * a couple of additional iterations help reducing the size
@@ -129,3 +145,103 @@ unsigned julia_it(
 
 	return it;
 }
+
+/* dz/dz_0 starts at 1 and goes 2 z dz */
+unsigned julia_de_it(
+		unsigned maxit,
+		long double *x_0, long double *y_0,
+		long double *cx, long double *cy,
+		long double *modulus, long double *distance)
+{
+	unsigned it = 1;
+
+	long double x;
+	long double y;
+	long double xc;
+	long double yc;
+	long double x2;
+	long double y2;
+	long double dx = 1;
+	long double dy = 0;
+
+	x = *x_0;
+	y = *y_0;
+
+	xc = *cx;
+	yc = *cy;
+
+	x2 = x * x;
+	y2 = y * y;
+
+	*distance = 0;
+
+	while ((x2 + y2) < DE_ESCAPE2 && it++ < maxit) {
+		long double ndx = 2 * (x * dx - y * dy);
+		dy = 2 * (x * dy + y * dx);
+		dx = ndx;
+		y = 2 * x * y + yc;
+		x = x2 - y2 + xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (it >= maxit)
+		return 0;
+
+	long double m = sqrtl(x2 + y2);
+	*distance = m * logl(m) / hypotl(dx, dy);
+	if (modulus)
+		*modulus = m;
+
+	return it;
+}
+
+#if defined(GMANDEL_HAVE_FLOAT128)
+unsigned julia_it_f128(
+		unsigned maxit,
+		gmandel_float128 *x_0, gmandel_float128 *y_0,
+		gmandel_float128 *cx, gmandel_float128 *cy,
+		long double *modulus)
+{
+	unsigned it = 1;
+
+	gmandel_float128 x;
+	gmandel_float128 y;
+	gmandel_float128 xc;
+	gmandel_float128 yc;
+	gmandel_float128 x2;
+	gmandel_float128 y2;
+
+	x = *x_0;
+	y = *y_0;
+
+	xc = *cx;
+	yc = *cy;
+
+	x2 = x * x;
+	y2 = y * y;
+
+	while ((x2 + y2) < 16 && it++ < maxit) {
+		y = 2 * x * y + yc;
+		x = x2 - y2 + xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (it >= maxit)
+		return 0;
+
+	unsigned n = 2;
+	while (n--) {
+		y = 2 * x * y + yc;
+		x = x2 - y2 + xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (modulus)
+		*modulus = sqrtl((long double)(x2 + y2));
+
+	return it;
+}
+#endif
@@ -44,6 +44,21 @@ unsigned julia_it(
 		unsigned maxit,
 		long double *x_0, long double *y_0,
 		long double *cx, long double *cy,
+		struct orbit_resume *r,
 		long double *modulus);
 
+unsigned julia_de_it(
+		unsigned maxit,
+		long double *x_0, long double *y_0,
+		long double *cx, long double *cy,
+		long double *modulus, long double *distance);
+
+#if defined(GMANDEL_HAVE_FLOAT128)
+unsigned julia_it_f128(
+		unsigned maxit,
+		gmandel_float128 *x_0, gmandel_float128 *y_0,
+		gmandel_float128 *cx, gmandel_float128 *cy,
+		long double *modulus);
+#endif
+
 #endif
@@ -108,6 +108,8 @@ struct orbit_point *mandelbrot_orbit(
 unsigned mandelbrot_it(
 		unsigned maxit,
 		long double *cx, long double *cy,
+		const struct interior_check *ic,
+		struct orbit_resume *r,
 		long double *modulus)
 {
 	unsigned it = 1;
@@ -125,20 +127,39 @@ unsigned mandelbrot_it(
 	x2 = x * x;
 	y2 = y * y;
 
-	if (mandelbrot_in_cardioid(x, y, y2))
+	if (r && r->it) {
+		x = r->x;
+		y = r->y;
+		x2 = x * x;
+		y2 = y * y;
+		it = r->it;
+		r->it = 0;
+	} else if (mandelbrot_in_cardioid(x, y, y2))
 		return 0;
 	else if (mandelbrot_in_biggest_mu_atom(x, y, y2))
 		return 0;
 
+	struct interior_state is;
+	interior_start(&is, ic, x, y);
+
 	while ((x2 + y2) < 4 && it++ < maxit) {
+		long double m2 = x2 + y2;
 		y = 2 * x * y + yc;
 		x = x2 - y2 + xc;
 		x2 = x * x;
 		y2 = y * y;
+		if (ic && (x2 + y2) < 4 && interior_caught(&is, x, y, m2))
+			return 0;
 	}
 
-	if (it >= maxit || it == 0)
+	if (it >= maxit || it == 0) {
+		if (r && it >= maxit) {
+			r->x = x;
+			r->y = y;
+			r->it = maxit;
+		}
 		return 0;
+	}
 
 	/* When using the renormalized formula for the escape radius,
 	 * a couple of additional iterations help reducing the size
@@ -157,3 +178,126 @@ unsigned mandelbrot_it(
 
 	return it;
 }
+
+/* dz/dc starts at 1, as the orbit starts at c, and goes 2 z dz + 1 */
+unsigned mandelbrot_de_it(
+		unsigned maxit,
+		long double *cx, long double *cy,
+		const struct interior_check *ic,
+		long double *modulus, long double *distance)
+{
+	unsigned it = 1;
+
+	long double x;
+	long double y;
+	long double xc;
+	long double yc;
+	long double x2;
+	long double y2;
+	long double dx = 1;
+	long double dy = 0;
+
+	x = xc = *cx;
+	y = yc = *cy;
+
+	x2 = x * x;
+	y2 = y * y;
+
+	*distance = 0;
+
+	if (mandelbrot_in_cardioid(x, y, y2))
+		return 0;
+	else if (mandelbrot_in_biggest_mu_atom(x, y, y2))
+		return 0;
+
+	struct interior_state is;
+	interior_start(&is, ic, x, y);
+
+	while ((x2 + y2) < DE_ESCAPE2 && it++ < maxit) {
+		long double m2 = x2 + y2;
+		long double ndx = 2 * (x * dx - y * dy) + 1;
+		dy = 2 * (x * dy + y * dx);
+		dx = ndx;
+		y = 2 * x * y + yc;
+		x = x2 - y2 + xc;
+		x2 = x * x;
+		y2 = y * y;
+		if (ic && (x2 + y2) < 4 && interior_caught(&is, x, y, m2))
+			return 0;
+	}
+
+	if (it >= maxit || it == 0)
+		return 0;
+
+	long double m = sqrtl(x2 + y2);
+	*distance = m * logl(m) / hypotl(dx, dy);
+	if (modulus)
+		*modulus = m;
+
+	return it;
+}
+
+#if defined(GMANDEL_HAVE_FLOAT128)
+/* Same as mandelbrot_in_cardioid and mandelbrot_in_biggest_mu_atom, but
+ * without square roots, which quad precision does not have in libm.
+ */
+static inline bool
+GMANDEL_ATTRIBUTE(const)
+mandelbrot_in_mu_atoms_f128(
+		gmandel_float128 x, gmandel_float128 y2)
+{
+	gmandel_float128 lx = x - 0.25Q;
+	gmandel_float128 q = lx * lx + y2;
+	if (q * (q + lx) < 0.25Q * y2)
+		return true;
+	gmandel_float128 bx = x + 1;
+	return bx * bx + y2 < 0.0625Q;
+}
+
+unsigned mandelbrot_it_f128(
+		unsigned maxit,
+		gmandel_float128 *cx, gmandel_float128 *cy,
+		long double *modulus)
+{
+	unsigned it = 1;
+
+	gmandel_float128 x;
+	gmandel_float128 y;
+	gmandel_float128 xc;
+	gmandel_float128 yc;
+	gmandel_float128 x2;
+	gmandel_float128 y2;
+
+	x = xc = *cx;
+	y = yc = *cy;
+
+	x2 = x * x;
+	y2 = y * y;
+
+	if (mandelbrot_in_mu_atoms_f128(x, y2))
+		return 0;
+
+	while ((x2 + y2) < 4 && it++ < maxit) {
+		y = 2 * x * y + yc;
+		x = x2 - y2 + xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (it >= maxit || it == 0)
+		return 0;
+
+	unsigned n = 2;
+	while (n--) {
+		y = 2 * x * y + yc;
+		x = x2 - y2 + xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (modulus)
+		*modulus = sqrtl((long double)(x2 + y2));
+
+	return it;
+}
+#endif
@@ -42,6 +42,21 @@ struct orbit_point *mandelbrot_orbit(
 unsigned mandelbrot_it(
 		unsigned maxit,
 		long double *cx, long double *cy,
+		const struct interior_check *ic,
+		struct orbit_resume *r,
 		long double *modulus);
 
+unsigned mandelbrot_de_it(
+		unsigned maxit,
+		long double *cx, long double *cy,
+		const struct interior_check *ic,
+		long double *modulus, long double *distance);
+
+#if defined(GMANDEL_HAVE_FLOAT128)
+unsigned mandelbrot_it_f128(
+		unsigned maxit,
+		gmandel_float128 *cx, gmandel_float128 *cy,
+		long double *modulus);
+#endif
+
 #endif
@@ -0,0 +1,178 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+
+#include "mpfix.h"
+
+#define N (MPFIX_LIMBS + 1)
+
+static bool mag_is_zero(const uint32_t *a)
+{
+	for (unsigned i = 0; i < N; i++)
+		if (a[i])
+			return false;
+	return true;
+}
+
+static int mag_cmp(const uint32_t *a, const uint32_t *b)
+{
+	for (unsigned i = N; i-- > 0; )
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	return 0;
+}
+
+static void mag_add(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+	uint64_t carry = 0;
+	for (unsigned i = 0; i < N; i++) {
+		carry += (uint64_t)a[i] + b[i];
+		r[i] = carry;
+		carry >>= 32;
+	}
+}
+
+/* requires a >= b */
+static void mag_sub(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+	int64_t borrow = 0;
+	for (unsigned i = 0; i < N; i++) {
+		int64_t t = (int64_t)a[i] - b[i] - borrow;
+		borrow = t < 0;
+		r[i] = t + (borrow << 32);
+	}
+}
+
+void mpfix_from_long_double(struct mpfix *r, long double v)
+{
+	r->neg = v < 0;
+	v = fabsl(v);
+
+	long double ip = floorl(v);
+	r->d[MPFIX_LIMBS] = ip;
+	v -= ip;
+
+	/* scaling by 2^32 is exact, so this is too */
+	for (unsigned i = MPFIX_LIMBS; i-- > 0; ) {
+		v = ldexpl(v, 32);
+		ip = floorl(v);
+		r->d[i] = ip;
+		v -= ip;
+	}
+}
+
+long double mpfix_to_long_double(const struct mpfix *a)
+{
+	long double r = 0;
+	for (unsigned i = 0; i < N; i++)
+		r += ldexpl(a->d[i], 32 * ((int)i - MPFIX_LIMBS));
+	return a->neg ? -r : r;
+}
+
+#if defined(GMANDEL_HAVE_FLOAT128)
+gmandel_float128 mpfix_to_f128(const struct mpfix *a)
+{
+	gmandel_float128 r = 0;
+	gmandel_float128 scale = 1;
+	for (unsigned i = MPFIX_LIMBS; i < N; i++)
+		r += a->d[i];
+	for (unsigned i = MPFIX_LIMBS; i-- > 0; ) {
+		scale /= 4294967296.0;
+		r += a->d[i] * scale;
+	}
+	return a->neg ? -r : r;
+}
+#endif
+
+static void add_signed(struct mpfix *r,
+		const struct mpfix *a, bool bneg, const struct mpfix *b)
+{
+	if (a->neg == bneg) {
+		mag_add(r->d, a->d, b->d);
+		r->neg = a->neg;
+	} else if (mag_cmp(a->d, b->d) >= 0) {
+		mag_sub(r->d, a->d, b->d);
+		r->neg = a->neg;
+	} else {
+		mag_sub(r->d, b->d, a->d);
+		r->neg = bneg;
+	}
+
+	if (mag_is_zero(r->d))
+		r->neg = false;
+}
+
+void mpfix_add(struct mpfix *r, const struct mpfix *a, const struct mpfix *b)
+{
+	add_signed(r, a, b->neg, b);
+}
+
+void mpfix_sub(struct mpfix *r, const struct mpfix *a, const struct mpfix *b)
+{
+	add_signed(r, a, !b->neg, b);
+}
+
+void mpfix_mul(struct mpfix *r, const struct mpfix *a, const struct mpfix *b)
+{
+	uint32_t p[2 * N] = { 0 };
+
+	for (unsigned i = 0; i < N; i++) {
+		if (!a->d[i])
+			continue;
+		uint64_t carry = 0;
+		for (unsigned j = 0; j < N; j++) {
+			carry += (uint64_t)a->d[i] * b->d[j] + p[i + j];
+			p[i + j] = carry;
+			carry >>= 32;
+		}
+		p[i + N] = carry;
+	}
+
+	r->neg = a->neg != b->neg;
+	for (unsigned i = 0; i < N; i++)
+		r->d[i] = p[i + MPFIX_LIMBS];
+
+	if (mag_is_zero(r->d))
+		r->neg = false;
+}
+
+void mpfix_add_long_double(struct mpfix *r, long double v)
+{
+	struct mpfix t;
+	mpfix_from_long_double(&t, v);
+	mpfix_add(r, r, &t);
+}
+
+bool mpfix_equal(const struct mpfix *a, const struct mpfix *b)
+{
+	return a->neg == b->neg && mag_cmp(a->d, b->d) == 0;
+}
@@ -0,0 +1,67 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_MPFIX_H_
+#define GMANDEL_MPFIX_H_ 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gfract_engines.h"
+
+/* Sign-magnitude fixed point numbers with one 32 bit integer limb and
+ * MPFIX_LIMBS fractional ones, enough to address pixels of views around
+ * 1e-120 wide. Only what the deep zoom code needs is here; operations
+ * truncate and do not check for overflow of the integer part.
+ */
+#define MPFIX_LIMBS 14
+
+struct mpfix {
+	bool neg;
+	/* little endian, d[MPFIX_LIMBS] is the integer part */
+	uint32_t d[MPFIX_LIMBS + 1];
+};
+
+void mpfix_from_long_double(struct mpfix *r, long double v);
+long double mpfix_to_long_double(const struct mpfix *a);
+#if defined(GMANDEL_HAVE_FLOAT128)
+gmandel_float128 mpfix_to_f128(const struct mpfix *a);
+#endif
+
+void mpfix_add(struct mpfix *r, const struct mpfix *a, const struct mpfix *b);
+void mpfix_sub(struct mpfix *r, const struct mpfix *a, const struct mpfix *b);
+void mpfix_mul(struct mpfix *r, const struct mpfix *a, const struct mpfix *b);
+
+void mpfix_add_long_double(struct mpfix *r, long double v);
+
+bool mpfix_equal(const struct mpfix *a, const struct mpfix *b);
+
+#endif
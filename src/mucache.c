@@ -0,0 +1,188 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fract.h"
+#include "mpfix.h"
+#include "mupoint.h"
+#include "xfuncs.h"
+#include "mucache.h"
+
+struct mucache_entry {
+	struct mucache_entry *next;
+	/* everything that goes into mu */
+	enum fract_type type;
+	struct fract_view view;
+	unsigned width;
+	unsigned height;
+	unsigned maxit;
+	long double cx;
+	long double cy;
+	bool subdivide;
+	unsigned interior_checks;
+	bool distance_fill;
+	enum fract_colouring colouring;
+	/* in row order, starting at the top left pixel */
+	gmandel_mu_t *mu;
+	long double avg_v;
+	unsigned avg_n;
+};
+
+static size_t entry_size(const struct mucache_entry *e)
+{
+	return sizeof(*e) + (size_t)e->width * e->height * sizeof(*e->mu);
+}
+
+static bool entry_matches(const struct mucache_entry *e,
+		const struct fract *f)
+{
+	return e->type == f->type
+		&& e->width == f->width
+		&& e->height == f->height
+		&& e->maxit == f->maxit
+		&& e->cx == f->cx
+		&& e->cy == f->cy
+		&& e->subdivide == f->subdivide
+		&& e->interior_checks == f->interior_checks
+		&& e->distance_fill == f->distance_fill
+		&& e->colouring == f->colouring
+		&& e->view.span == f->view.span
+		&& mpfix_equal(&e->view.ulx_mp, &f->view.ulx_mp)
+		&& mpfix_equal(&e->view.uly_mp, &f->view.uly_mp);
+}
+
+static void entry_free(struct mucache_entry *e)
+{
+	free(e->mu);
+	free(e);
+}
+
+/* Takes the entry matching f out of the list, if any */
+static struct mucache_entry *unlink_match(struct mucache *c,
+		const struct fract *f)
+{
+	for (struct mucache_entry **p = &c->head; *p; p = &(*p)->next)
+		if (entry_matches(*p, f)) {
+			struct mucache_entry *e = *p;
+			*p = e->next;
+			c->used -= entry_size(e);
+			return e;
+		}
+
+	return NULL;
+}
+
+/* The list goes from the most to the least recently used */
+static void evict(struct mucache *c)
+{
+	while (c->used > c->budget) {
+		struct mucache_entry **p = &c->head;
+		while ((*p)->next)
+			p = &(*p)->next;
+		c->used -= entry_size(*p);
+		entry_free(*p);
+		*p = NULL;
+	}
+}
+
+void mucache_init(struct mucache *c, size_t budget)
+{
+	c->head = NULL;
+	c->used = 0;
+	c->budget = budget;
+}
+
+void mucache_destroy(struct mucache *c)
+{
+	mucache_set_budget(c, 0);
+}
+
+void mucache_set_budget(struct mucache *c, size_t budget)
+{
+	c->budget = budget;
+	evict(c);
+}
+
+void mucache_store(struct mucache *c, const struct fract *f)
+{
+	struct mucache_entry *e = unlink_match(c, f);
+	if (e)
+		entry_free(e);
+
+	e = xmalloc(sizeof(*e));
+	e->type = f->type;
+	e->view = f->view;
+	e->width = f->width;
+	e->height = f->height;
+	e->maxit = f->maxit;
+	e->cx = f->cx;
+	e->cy = f->cy;
+	e->subdivide = f->subdivide;
+	e->interior_checks = f->interior_checks;
+	e->distance_fill = f->distance_fill;
+	e->colouring = f->colouring;
+	e->avg_v = f->avgfactor.v;
+	e->avg_n = f->avgfactor.n;
+
+	if (entry_size(e) > c->budget) {
+		free(e);
+		return;
+	}
+
+	e->mu = xmalloc((size_t)f->width * f->height * sizeof(*e->mu));
+	gmandel_mu_t *p = e->mu;
+	for (unsigned j = 0; j < f->height; j++)
+		for (unsigned i = 0; i < f->width; i++)
+			*p++ = MUPOINT_AT(&f->mupoint, i, j);
+
+	e->next = c->head;
+	c->head = e;
+	c->used += entry_size(e);
+	evict(c);
+}
+
+bool mucache_restore(struct mucache *c, struct fract *f)
+{
+	struct mucache_entry *e = unlink_match(c, f);
+	if (!e)
+		return false;
+
+	fract_load_mu(f, e->mu);
+	f->avgfactor.v = e->avg_v;
+	f->avgfactor.n = e->avg_n;
+
+	e->next = c->head;
+	c->head = e;
+	c->used += entry_size(e);
+	return true;
+}
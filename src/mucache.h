@@ -0,0 +1,64 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_MUCACHE_H_
+#define GMANDEL_MUCACHE_H_ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "fract.h"
+
+/* Finished renders kept around so that going back to a view doesn't
+ * iterate it again. Entries are the whole mu buffer and the energy
+ * average of a render that ran to the end, and only match a fract
+ * looking at the same view with the same size and settings. Once
+ * their buffers add up to more than the budget, in bytes, the least
+ * recently used go first.
+ */
+struct mucache_entry;
+
+struct mucache {
+	struct mucache_entry *head;
+	size_t used;
+	size_t budget;
+};
+
+void mucache_init(struct mucache *c, size_t budget);
+void mucache_destroy(struct mucache *c);
+void mucache_set_budget(struct mucache *c, size_t budget);
+
+/* f must hold a render of its view that ran to the end */
+void mucache_store(struct mucache *c, const struct fract *f);
+/* Loads a render of f's view into it, if there is one */
+bool mucache_restore(struct mucache *c, struct fract *f);
+
+#endif
@@ -29,90 +29,89 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <string.h>
-
 #include "mupoint.h"
 #include "xfuncs.h"
 
+#define MUPOINT_ALIGN 64
+
 void mupoint_free(struct mupoint *m)
 {
-	for (unsigned i = 0; i < m->width; i++)
-		free(m->mu[i]);
 	free(m->mu);
 	m->mu = NULL;
 }
 
-void mupoint_clean_col(struct mupoint *m, unsigned i)
+void mupoint_clean(struct mupoint *m)
 {
-	for (unsigned j = 0; j < m->height; j++)
-		m->mu[i][j] = -1L;
+	size_t n = (size_t)m->width * m->height;
+	for (size_t k = 0; k < n; k++)
+		m->mu[k] = -1L;
 }
 
-void mupoint_clean(struct mupoint *m)
+static void clean_rows(struct mupoint *m, unsigned j0, unsigned j1)
 {
-	for (unsigned i = 0; i < m->width; i++)
-		mupoint_clean_col(m, i);
+	for (unsigned j = j0; j < j1; j++)
+		for (unsigned i = 0; i < m->width; i++)
+			MUPOINT_AT(m, i, j) = -1L;
+}
+
+static void clean_cols(struct mupoint *m, unsigned i0, unsigned i1)
+{
+	for (unsigned j = 0; j < m->height; j++)
+		for (unsigned i = i0; i < i1; i++)
+			MUPOINT_AT(m, i, j) = -1L;
 }
 
 void mupoint_create_as_needed(struct mupoint *m, unsigned w, unsigned h)
 {
-	if (!m->mu) {
-		m->width = w;
-		m->height = h;
-		m->mu = xmalloc(m->width * sizeof(*m->mu));
-		for (unsigned i = 0; i < m->width; i++)
-			m->mu[i] = xmalloc(m->height * sizeof(**m->mu));
-		mupoint_clean(m);
-	} else if (w > m->width || h > m->height) {
-		unsigned max_w = w > m->width ? w : m->width;
-		if (w > m->width)
-			m->mu = xrealloc(m->mu, w * sizeof(*m->mu));
-		if (h > m->height)
-			for (unsigned i = 0; i < max_w; i++)
-				m->mu[i] = i < m->width
-					? xrealloc(m->mu[i], h * sizeof(**m->mu))
-					: xmalloc(h * sizeof(**m->mu));
-		else
-			for (unsigned i = m->width; i < w; i++)
-				m->mu[i] = xmalloc(m->height * sizeof(**m->mu));
-		m->width = w;
-		m->height = h;
-		mupoint_clean(m);
-	}
+	if (m->mu && w == m->width && h == m->height)
+		return;
+
+	free(m->mu);
+	m->width = w;
+	m->height = h;
+	m->ox = 0;
+	m->oy = 0;
+	m->mu = xmalloc_aligned(MUPOINT_ALIGN,
+			(size_t)w * h * sizeof(*m->mu));
+	mupoint_clean(m);
 }
 
-void mupoint_move_up(struct mupoint *m)
+void mupoint_move_up(struct mupoint *m, unsigned n)
 {
-	size_t num = (m->height - 1) * sizeof(**m->mu);
-	for (unsigned i = 0; i < m->width; i++) {
-		memmove(&m->mu[i][1], &m->mu[i][0], num);
-		m->mu[i][0] = -1L;
+	if (n >= m->height) {
+		mupoint_clean(m);
+		return;
 	}
+	m->oy = (m->oy + m->height - n) % m->height;
+	clean_rows(m, 0, n);
 }
 
-void mupoint_move_down(struct mupoint *m)
+void mupoint_move_down(struct mupoint *m, unsigned n)
 {
-	size_t num = (m->height - 1) * sizeof(**m->mu);
-	for (unsigned i = 0; i < m->width; i++) {
-		memmove(&m->mu[i][0], &m->mu[i][1], num);
-		m->mu[i][m->height - 1] = -1L;
+	if (n >= m->height) {
+		mupoint_clean(m);
+		return;
 	}
+	m->oy = (m->oy + n) % m->height;
+	clean_rows(m, m->height - n, m->height);
 }
 
-void mupoint_move_right(struct mupoint *m)
+void mupoint_move_right(struct mupoint *m, unsigned n)
 {
-	size_t num = (m->width - 1) * sizeof(*m->mu);
-	void *p = m->mu[0];
-	memmove(&m->mu[0], &m->mu[1], num);
-	m->mu[m->width - 1] = p;
-	mupoint_clean_col(m, m->width - 1);
+	if (n >= m->width) {
+		mupoint_clean(m);
+		return;
+	}
+	m->ox = (m->ox + n) % m->width;
+	clean_cols(m, m->width - n, m->width);
 }
 
-void mupoint_move_left(struct mupoint *m)
+void mupoint_move_left(struct mupoint *m, unsigned n)
 {
-	size_t num = (m->width - 1) * sizeof(*m->mu);
-	void *p = m->mu[m->width - 1];
-	memmove(&m->mu[1], &m->mu[0], num);
-	m->mu[0] = p;
-	mupoint_clean_col(m, 0);
+	if (n >= m->width) {
+		mupoint_clean(m);
+		return;
+	}
+	m->ox = (m->ox + m->width - n) % m->width;
+	clean_cols(m, 0, n);
 }
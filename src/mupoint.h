@@ -32,24 +32,54 @@
 #ifndef GMANDEL_MUPOINT_H_
 #define GMANDEL_MUPOINT_H_ 1
 
+#include <stddef.h>
+
+/* Storage type of the smooth iteration counts, picked with configure's
+ * --with-mu-type. The 24 bits of a float are plenty for colouring.
+ */
+#if defined(GMANDEL_MU_LONG_DOUBLE)
 typedef long double gmandel_mu_t;
+#elif defined(GMANDEL_MU_DOUBLE)
+typedef double gmandel_mu_t;
+#else
+typedef float gmandel_mu_t;
+#endif
 
+/* One cache aligned, row-major buffer. -1 marks pixels still to be
+ * computed. Pixel (0, 0) lives at (ox, oy) and the rest wrap around,
+ * so panning only moves the origin and cleans the exposed strips.
+ */
 struct mupoint {
-	gmandel_mu_t **mu;
+	gmandel_mu_t *mu;
 	unsigned width;
 	unsigned height;
+	unsigned ox;
+	unsigned oy;
 };
 
+static inline gmandel_mu_t *mupoint_at(const struct mupoint *m,
+		unsigned i, unsigned j)
+{
+	unsigned x = i + m->ox;
+	unsigned y = j + m->oy;
+	if (x >= m->width)
+		x -= m->width;
+	if (y >= m->height)
+		y -= m->height;
+	return &m->mu[(size_t)y * m->width + x];
+}
+
+#define MUPOINT_AT(m, i, j) (*mupoint_at((m), (i), (j)))
+
 void mupoint_free(struct mupoint *m);
 
-void mupoint_clean_col(struct mupoint *m, unsigned i);
 void mupoint_clean(struct mupoint *m);
 
 void mupoint_create_as_needed(struct mupoint *m, unsigned w, unsigned h);
 
-void mupoint_move_up(struct mupoint *m);
-void mupoint_move_down(struct mupoint *m);
-void mupoint_move_right(struct mupoint *m);
-void mupoint_move_left(struct mupoint *m);
+void mupoint_move_up(struct mupoint *m, unsigned n);
+void mupoint_move_down(struct mupoint *m, unsigned n);
+void mupoint_move_right(struct mupoint *m, unsigned n);
+void mupoint_move_left(struct mupoint *m, unsigned n);
 
 #endif
@@ -0,0 +1,190 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "xfuncs.h"
+#include "perturb.h"
+
+/* A point whose orbit gets this close to zero relative to the reference
+ * has lost too many bits of its offset (Pauldelbrot's criterion).
+ */
+#define GLITCH_TOLERANCE 1e-6L
+
+static long double radius2(const struct perturb_ref *r)
+{
+	return r->type == PERTURB_MANDELBROT ? 4 : 16;
+}
+
+void perturb_ref_init(struct perturb_ref *r, enum perturb_type type,
+		long double cx, long double cy)
+{
+	r->type = type;
+	r->cx = cx;
+	r->cy = cy;
+	r->n = 0;
+	r->x = NULL;
+	r->y = NULL;
+	r->glitch = NULL;
+}
+
+void perturb_ref_free(struct perturb_ref *r)
+{
+	free(r->x);
+	free(r->y);
+	free(r->glitch);
+	r->x = r->y = r->glitch = NULL;
+	r->n = 0;
+}
+
+void perturb_ref_compute(struct perturb_ref *r, unsigned maxit,
+		const struct mpfix *x0, const struct mpfix *y0)
+{
+	struct mpfix x = *x0;
+	struct mpfix y = *y0;
+	struct mpfix xc;
+	struct mpfix yc;
+	struct mpfix x2;
+	struct mpfix y2;
+	struct mpfix t;
+
+	if (r->type == PERTURB_MANDELBROT) {
+		xc = *x0;
+		yc = *y0;
+	} else {
+		mpfix_from_long_double(&xc, r->cx);
+		mpfix_from_long_double(&yc, r->cy);
+	}
+
+	r->x = xrealloc(r->x, maxit * sizeof(*r->x));
+	r->y = xrealloc(r->y, maxit * sizeof(*r->y));
+	r->glitch = xrealloc(r->glitch, maxit * sizeof(*r->glitch));
+
+	/* The escaping point is stored too, points close to the reference
+	 * may still need it to notice they escape at the same time.
+	 */
+	for (r->n = 0; r->n < maxit; ) {
+		long double lx = mpfix_to_long_double(&x);
+		long double ly = mpfix_to_long_double(&y);
+		long double m = lx * lx + ly * ly;
+
+		r->x[r->n] = lx;
+		r->y[r->n] = ly;
+		r->glitch[r->n] = m * GLITCH_TOLERANCE;
+		r->n++;
+
+		if (m >= radius2(r))
+			break;
+
+		mpfix_mul(&x2, &x, &x);
+		mpfix_mul(&y2, &y, &y);
+		mpfix_mul(&t, &x, &y);
+		mpfix_add(&t, &t, &t);
+		mpfix_add(&y, &t, &yc);
+		mpfix_sub(&t, &x2, &y2);
+		mpfix_add(&x, &t, &xc);
+	}
+}
+
+unsigned perturb_it(const struct perturb_ref *r, unsigned maxit,
+		long double dx, long double dy,
+		long double *modulus, bool *glitched)
+{
+	const long double rad2 = radius2(r);
+	long double dcx = 0;
+	long double dcy = 0;
+	long double x;
+	long double y;
+	long double x2;
+	long double y2;
+	unsigned k;
+
+	if (r->type == PERTURB_MANDELBROT) {
+		dcx = dx;
+		dcy = dy;
+	}
+
+	*glitched = false;
+
+	for (k = 0; ; k++) {
+		if (k >= r->n) {
+			/* the reference escaped before this point did */
+			*glitched = true;
+			return 0;
+		}
+
+		x = r->x[k] + dx;
+		y = r->y[k] + dy;
+		x2 = x * x;
+		y2 = y * y;
+
+		/* as mandelbrot_it() and julia_it() have it, reaching maxit
+		 * is not escaping even on the last iteration
+		 */
+		if (k + 1 >= maxit)
+			return 0;
+		if (x2 + y2 >= rad2)
+			break;
+		if (x2 + y2 < r->glitch[k]) {
+			*glitched = true;
+			return 0;
+		}
+
+		long double nx = 2 * (r->x[k] * dx - r->y[k] * dy)
+			+ dx * dx - dy * dy + dcx;
+		dy = 2 * (r->x[k] * dy + r->y[k] * dx) + 2 * dx * dy + dcy;
+		dx = nx;
+	}
+
+	/* The extra iterations for the renormalized escape radius are done
+	 * on the full values, which are far from zero by now.
+	 */
+	long double xc = r->cx;
+	long double yc = r->cy;
+	if (r->type == PERTURB_MANDELBROT) {
+		xc = r->x[0] + dcx;
+		yc = r->y[0] + dcy;
+	}
+
+	unsigned n = 2;
+	while (n--) {
+		y = 2 * x * y + yc;
+		x = x2 - y2 + xc;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	if (modulus)
+		*modulus = sqrtl(x2 + y2);
+
+	return k + 1;
+}
@@ -0,0 +1,81 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_PERTURB_H_
+#define GMANDEL_PERTURB_H_ 1
+
+#include <stdbool.h>
+
+#include "mpfix.h"
+
+/* Perturbation theory for views too deep for any native type: one
+ * reference orbit Z_n is iterated with struct mpfix and stored rounded
+ * to long double, every other point only iterates its offset d_n from
+ * it:
+ *
+ *   d_n+1 = 2 Z_n d_n + d_n^2 + dc
+ *
+ * where dc is the offset of c for Mandelbrot and zero for Julia sets.
+ */
+enum perturb_type {
+	PERTURB_MANDELBROT,
+	PERTURB_JULIA,
+};
+
+struct perturb_ref {
+	enum perturb_type type;
+	long double cx;
+	long double cy;
+	unsigned n;
+	long double *x;
+	long double *y;
+	long double *glitch;
+};
+
+void perturb_ref_init(struct perturb_ref *r, enum perturb_type type,
+		long double cx, long double cy);
+void perturb_ref_free(struct perturb_ref *r);
+
+/* For Mandelbrot sets (x0, y0) is c, for Julia sets it is z_0 and c is
+ * the one given to perturb_ref_init.
+ */
+void perturb_ref_compute(struct perturb_ref *r, unsigned maxit,
+		const struct mpfix *x0, const struct mpfix *y0);
+
+/* Same result as mandelbrot_it/julia_it for the point at offset (dx, dy)
+ * from the reference. When the reference cannot be trusted for it,
+ * *glitched is set and the return value is meaningless.
+ */
+unsigned perturb_it(const struct perturb_ref *r, unsigned maxit,
+		long double dx, long double dy,
+		long double *modulus, bool *glitched);
+
+#endif
@@ -0,0 +1,199 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+
+#include "simd.h"
+#include "xfuncs.h"
+
+enum simd_fract {
+	SIMD_MANDELBROT,
+	SIMD_JULIA,
+	SIMD_BURNINGSHIP,
+};
+
+typedef void (*simd_kernel)(unsigned maxit,
+		const double *x, const double *y, double jx, double jy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus);
+
+struct simd_kernels {
+	const char *name;
+	unsigned lanes[2];
+	simd_kernel mandelbrot[2];
+	simd_kernel julia[2];
+	simd_kernel burningship[2];
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#    define SIMD_X86 1
+#endif
+
+/* Every instruction set gets a double and a float build of the kernels,
+ * both using the full vector width.
+ */
+#define SIMD_REAL double
+#define SIMD_INT long long
+#define SIMD_INT_MAX LLONG_MAX
+#define SIMD_ABSMASK 0x7fffffffffffffffLL
+#include "simd_isa.h"
+#undef SIMD_ABSMASK
+#undef SIMD_INT_MAX
+#undef SIMD_INT
+#undef SIMD_REAL
+
+#define SIMD_FLOAT 1
+#define SIMD_REAL float
+#define SIMD_INT int
+#define SIMD_INT_MAX INT_MAX
+#define SIMD_ABSMASK 0x7fffffff
+#include "simd_isa.h"
+#undef SIMD_ABSMASK
+#undef SIMD_INT_MAX
+#undef SIMD_INT
+#undef SIMD_REAL
+#undef SIMD_FLOAT
+
+#define KERNELS(n, l) { #n, { l, 2 * l }, \
+	{ n##_mandelbrot, n##f_mandelbrot }, \
+	{ n##_julia, n##f_julia }, \
+	{ n##_burningship, n##f_burningship } }
+
+static const struct simd_kernels all_kernels[] = {
+#if defined(SIMD_X86)
+	KERNELS(avx512, 8),
+	KERNELS(avx2, 4),
+	KERNELS(sse2, 2),
+#endif
+	KERNELS(scalar, 1),
+};
+
+#undef KERNELS
+
+static const struct simd_kernels *kernels = NULL;
+
+static bool cpu_supports(const char *name)
+{
+#if defined(SIMD_X86)
+	__builtin_cpu_init();
+	if (strcmp(name, "avx512") == 0)
+		return __builtin_cpu_supports("avx512f");
+	else if (strcmp(name, "avx2") == 0)
+		return __builtin_cpu_supports("avx2");
+	else if (strcmp(name, "sse2") == 0)
+		return __builtin_cpu_supports("sse2");
+#endif
+	return strcmp(name, "scalar") == 0;
+}
+
+void simd_init(void)
+{
+	if (kernels)
+		return;
+
+	/* GMANDEL_SIMD lets us force a narrower set when comparing output */
+	const char *force = getenv("GMANDEL_SIMD");
+
+	for (unsigned i = 0; i < sizeof(all_kernels) / sizeof(*all_kernels); i++) {
+		const struct simd_kernels *k = &all_kernels[i];
+		if (force && strcmp(force, k->name) != 0)
+			continue;
+		if (cpu_supports(k->name)) {
+			kernels = k;
+			return;
+		}
+	}
+
+	kernels = &all_kernels[sizeof(all_kernels) / sizeof(*all_kernels) - 1];
+}
+
+const char *simd_get_name(void)
+{
+	simd_init();
+	return kernels->name;
+}
+
+unsigned simd_get_lanes(enum simd_precision p)
+{
+	simd_init();
+	return kernels->lanes[p];
+}
+
+static void run(enum simd_precision p, const simd_kernel *k, unsigned maxit,
+		const double *x, const double *y, double jx, double jy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	unsigned lanes = kernels->lanes[p];
+	for (unsigned i = 0; i < n; i += lanes) {
+		unsigned left = n - i < lanes ? n - i : lanes;
+		(*k[p])(maxit, x + i, y + i, jx, jy, ic, r ? r + i : NULL,
+				left, it + i, modulus + i);
+	}
+}
+
+void simd_mandelbrot_it(
+		enum simd_precision p,
+		unsigned maxit,
+		const double *cx, const double *cy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	simd_init();
+	run(p, kernels->mandelbrot, maxit, cx, cy, 0, 0, ic, r,
+			n, it, modulus);
+}
+
+void simd_julia_it(
+		enum simd_precision p,
+		unsigned maxit,
+		const double *x_0, const double *y_0,
+		double cx, double cy, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	simd_init();
+	run(p, kernels->julia, maxit, x_0, y_0, cx, cy, NULL, r,
+			n, it, modulus);
+}
+
+void simd_burningship_it(
+		enum simd_precision p,
+		unsigned maxit,
+		const double *cx, const double *cy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	simd_init();
+	run(p, kernels->burningship, maxit, cx, cy, 0, 0, ic, r,
+			n, it, modulus);
+}
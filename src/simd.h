@@ -0,0 +1,74 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_SIMD_H_
+#define GMANDEL_SIMD_H_ 1
+
+#include "gfract_engines.h"
+
+/* Double and single precision versions of mandelbrot_it, julia_it and
+ * burningship_it that iterate several pixels at once. The widest
+ * instruction set the CPU supports is picked by simd_init(). Results
+ * follow the scalar kernels: it[k] is 0 for points considered inside
+ * the set, and r, when not NULL, holds an orbit_resume for each point.
+ */
+
+enum simd_precision {
+	SIMD_DOUBLE = 0,
+	SIMD_SINGLE,
+};
+
+void simd_init(void);
+const char *simd_get_name(void);
+unsigned simd_get_lanes(enum simd_precision p);
+
+void simd_mandelbrot_it(
+		enum simd_precision p,
+		unsigned maxit,
+		const double *cx, const double *cy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus);
+
+void simd_julia_it(
+		enum simd_precision p,
+		unsigned maxit,
+		const double *x_0, const double *y_0,
+		double cx, double cy, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus);
+
+void simd_burningship_it(
+		enum simd_precision p,
+		unsigned maxit,
+		const double *cx, const double *cy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus);
+
+#endif
@@ -0,0 +1,80 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Instantiates simd_kernels.h for every instruction set we know about,
+ * for the SIMD_REAL chosen by simd.c. Float builds get an 'f' suffix.
+ * Included twice on purpose, so it has no include guard.
+ */
+
+#if defined(SIMD_FLOAT)
+#    define SIMD_ISA(isa, x) isa##f_##x
+#else
+#    define SIMD_ISA(isa, x) isa##_##x
+#endif
+
+#define SIMD_LANES (1 * sizeof(double) / sizeof(SIMD_REAL))
+#define SIMD_NAME(x) SIMD_ISA(scalar, x)
+#include "simd_kernels.h"
+#undef SIMD_NAME
+#undef SIMD_LANES
+
+#if defined(SIMD_X86)
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#define SIMD_LANES (2 * sizeof(double) / sizeof(SIMD_REAL))
+#define SIMD_NAME(x) SIMD_ISA(sse2, x)
+#include "simd_kernels.h"
+#undef SIMD_NAME
+#undef SIMD_LANES
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define SIMD_LANES (4 * sizeof(double) / sizeof(SIMD_REAL))
+#define SIMD_NAME(x) SIMD_ISA(avx2, x)
+#include "simd_kernels.h"
+#undef SIMD_NAME
+#undef SIMD_LANES
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define SIMD_LANES (8 * sizeof(double) / sizeof(SIMD_REAL))
+#define SIMD_NAME(x) SIMD_ISA(avx512, x)
+#include "simd_kernels.h"
+#undef SIMD_NAME
+#undef SIMD_LANES
+#pragma GCC pop_options
+
+#endif
+
+#undef SIMD_ISA
@@ -0,0 +1,252 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Escape-time kernels written once with GCC vector extensions and built
+ * once per instruction set and precision by simd.c. This file is included
+ * several times on purpose, with SIMD_LANES, SIMD_REAL, SIMD_INT,
+ * SIMD_ABSMASK and SIMD_NAME(x) defined by the includer, so it has no
+ * include guard.
+ */
+
+typedef SIMD_REAL SIMD_NAME(vd)
+	__attribute__((vector_size(SIMD_LANES * sizeof(SIMD_REAL))));
+typedef SIMD_INT SIMD_NAME(vi)
+	__attribute__((vector_size(SIMD_LANES * sizeof(SIMD_INT))));
+
+#define vd SIMD_NAME(vd)
+#define vi SIMD_NAME(vi)
+
+static inline bool SIMD_NAME(any)(vi m)
+{
+	SIMD_INT r = 0;
+	for (unsigned l = 0; l < SIMD_LANES; l++)
+		r |= m[l];
+	return r != 0;
+}
+
+static inline vd SIMD_NAME(blend)(vi m, vd a, vd b)
+{
+	return (vd)(((vi)a & m) | ((vi)b & ~m));
+}
+
+/* The burning ship's fabs() is just clearing the sign bit */
+static inline vd SIMD_NAME(abs)(vd a)
+{
+	const vi absmask = (vi){ 0 } + SIMD_ABSMASK;
+	return (vd)((vi)a & absmask);
+}
+
+static inline GMANDEL_ATTRIBUTE(always_inline)
+void SIMD_NAME(iterate)(enum simd_fract type,
+		unsigned maxit, const double *px, const double *py,
+		double jx, double jy, const struct interior_check *ic,
+		struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	vd x;
+	vd y;
+	vd xc;
+	vd yc;
+	vd x2;
+	vd y2;
+	const SIMD_REAL radius = type == SIMD_JULIA ? 16 : 4;
+
+	/* unused lanes start outside the escape radius and stay masked */
+	for (unsigned l = 0; l < SIMD_LANES; l++) {
+		x[l] = l < n ? px[l] : 8;
+		y[l] = l < n ? py[l] : 0;
+	}
+
+	if (type == SIMD_JULIA) {
+		xc = (vd){ 0 } + (SIMD_REAL)jx;
+		yc = (vd){ 0 } + (SIMD_REAL)jy;
+	} else {
+		xc = x;
+		yc = y;
+	}
+
+	x2 = x * x;
+	y2 = y * y;
+
+	vi inside = (vi){ 0 };
+
+	if (type == SIMD_MANDELBROT) {
+		vd lx = x - (SIMD_REAL)0.25;
+		vd q = lx * lx + y2;
+		vi cardioid = q * (q + lx) < (SIMD_REAL)0.25 * y2;
+		vd bx = x + 1;
+		vi bulb = bx * bx + y2 < (SIMD_REAL)0.0625;
+		inside = cardioid | bulb;
+	}
+
+	/* resumed lanes pick up their own count, so each runs out of
+	 * iterations on its own
+	 */
+	vi count = (vi){ 0 };
+	if (r) {
+		for (unsigned l = 0; l < SIMD_LANES && l < n; l++) {
+			if (!r[l].it)
+				continue;
+			x[l] = r[l].x;
+			y[l] = r[l].y;
+			count[l] = r[l].it - 1;
+			r[l].it = 0;
+		}
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	vi active = ((x2 + y2) < radius) & ~inside;
+
+	/* count is as wide as the lanes, which caps maxit for floats */
+	const SIMD_INT last = maxit == 0 ? 0
+		: (unsigned long long)maxit - 1 < SIMD_INT_MAX
+		? (SIMD_INT)(maxit - 1) : SIMD_INT_MAX;
+
+	/* Same as interior_caught(), all lanes share Brent's schedule */
+	const SIMD_REAL eps2 = ic ? ic->eps * ic->eps : 0;
+	const SIMD_REAL deriv_eps = ic ? ic->deriv_eps : 0;
+	vd sx = x;
+	vd sy = y;
+	vd d2 = (vd){ 0 } + 1;
+	unsigned step = 0;
+	unsigned lap = 1;
+
+	for (;;) {
+		active &= count < last;
+		if (!SIMD_NAME(any)(active))
+			break;
+
+		vd m2 = x2 + y2;
+		vd ny;
+		vd nx;
+		if (type == SIMD_BURNINGSHIP) {
+			ny = 2 * SIMD_NAME(abs)(x * y) - yc;
+			nx = x2 - y2 - xc;
+		} else {
+			ny = 2 * x * y + yc;
+			nx = x2 - y2 + xc;
+		}
+		x = SIMD_NAME(blend)(active, nx, x);
+		y = SIMD_NAME(blend)(active, ny, y);
+		x2 = x * x;
+		y2 = y * y;
+		count -= active;
+		active &= (x2 + y2) < radius;
+
+		/* caught lanes stop inside the radius, so they come out as 0 */
+		if (deriv_eps > 0) {
+			d2 *= 4 * m2;
+			active &= ~(d2 < deriv_eps);
+		}
+		if (eps2 > 0) {
+			vd dx = x - sx;
+			vd dy = y - sy;
+			active &= ~(dx * dx + dy * dy < eps2);
+			if (++step == lap) {
+				sx = x;
+				sy = y;
+				step = 0;
+				lap *= 2;
+			}
+		}
+	}
+
+	vi escaped = (x2 + y2) >= radius;
+
+	if (r) {
+		for (unsigned l = 0; l < SIMD_LANES && l < n; l++) {
+			if (count[l] < last)
+				continue;
+			r[l].x = x[l];
+			r[l].y = y[l];
+			r[l].it = count[l] + 1;
+		}
+	}
+
+	/* When using the renormalized formula for the escape radius,
+	 * a couple of additional iterations help reducing the size
+	 * of the error term.
+	 */
+	for (unsigned k = 0; k < 2; k++) {
+		vd ny;
+		vd nx;
+		if (type == SIMD_BURNINGSHIP) {
+			ny = 2 * SIMD_NAME(abs)(x * y) - yc;
+			nx = x2 - y2 - xc;
+		} else {
+			ny = 2 * x * y + yc;
+			nx = x2 - y2 + xc;
+		}
+		x = nx;
+		y = ny;
+		x2 = x * x;
+		y2 = y * y;
+	}
+
+	for (unsigned l = 0; l < SIMD_LANES && l < n; l++) {
+		if (escaped[l] && (unsigned)count[l] + 1 < maxit) {
+			it[l] = count[l] + 1;
+			modulus[l] = sqrt((double)x2[l] + y2[l]);
+		} else
+			it[l] = 0;
+	}
+}
+
+static void SIMD_NAME(mandelbrot)(unsigned maxit,
+		const double *cx, const double *cy, double jx, double jy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	SIMD_NAME(iterate)(SIMD_MANDELBROT, maxit, cx, cy, jx, jy, ic, r,
+			n, it, modulus);
+}
+
+static void SIMD_NAME(julia)(unsigned maxit,
+		const double *x_0, const double *y_0, double jx, double jy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	SIMD_NAME(iterate)(SIMD_JULIA, maxit, x_0, y_0, jx, jy, ic, r,
+			n, it, modulus);
+}
+
+static void SIMD_NAME(burningship)(unsigned maxit,
+		const double *cx, const double *cy, double jx, double jy,
+		const struct interior_check *ic, struct orbit_resume *r,
+		unsigned n, unsigned *it, double *modulus)
+{
+	SIMD_NAME(iterate)(SIMD_BURNINGSHIP, maxit, cx, cy, jx, jy, ic, r,
+			n, it, modulus);
+}
+
+#undef vd
+#undef vi
@@ -0,0 +1,216 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "state.h"
+#include "xfuncs.h"
+
+enum {
+	GMANDEL_STATE_0 = 0, /* old, unsupported, format */
+	GMANDEL_STATE_1,
+	GMANDEL_STATE_2,
+	GMANDEL_STATE_CURRENT = GMANDEL_STATE_2,
+	GMANDEL_STATE_LAST,
+};
+
+static const char *format_strings[] = {
+	[GMANDEL_STATE_1] = "gmandel-1",
+	[GMANDEL_STATE_2] = "gmandel-2",
+	[GMANDEL_STATE_LAST] = NULL,
+};
+
+struct reader {
+	FILE *file;
+	char *err;
+	size_t errlen;
+	char buf[BUFSIZ];
+};
+
+static void state_stripnl(char *s)
+{
+	for (; s && *s; s++)
+		if (*s == '\n')
+			*s = '\0';
+}
+
+static bool state_fgets(struct reader *r)
+{
+	if (fgets(r->buf, sizeof(r->buf), r->file) != NULL) {
+		state_stripnl(r->buf);
+		return true;
+	}
+
+	if (feof(r->file))
+		snprintf(r->err, r->errlen, "Unexpected EOF");
+	else
+		snprintf(r->err, r->errlen, "Unexpected error");
+
+	return false;
+}
+
+static bool state_strtoul(struct reader *r, const char *var,
+		unsigned long *value)
+{
+	if (!state_fgets(r))
+		return false;
+
+	char *endptr;
+	errno = 0;
+	*value = strtoul(r->buf, &endptr, 10);
+	if (endptr == r->buf || *endptr) {
+		snprintf(r->err, r->errlen,
+				"Could not get a sane value for %s", var);
+		return false;
+	} else if (errno) {
+		snprintf(r->err, r->errlen,
+				"Could not get a sane value for %s: %s",
+				var, strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+static bool state_strtod(struct reader *r, const char *var, double *value)
+{
+	if (!state_fgets(r))
+		return false;
+
+	char *endptr;
+	errno = 0;
+	*value = strtod(r->buf, &endptr);
+	if (endptr == r->buf || *endptr) {
+		snprintf(r->err, r->errlen,
+				"Could not get a sane value for %s", var);
+		return false;
+	} else if (errno) {
+		snprintf(r->err, r->errlen,
+				"Could not get a sane value for %s: %s",
+				var, strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+static bool state_limits_read(struct reader *r, struct state_limits *l)
+{
+	return state_strtod(r, "ulx", &l->ulx)
+		&& state_strtod(r, "uly", &l->uly)
+		&& state_strtod(r, "lly", &l->lly);
+}
+
+static bool loader_1(struct reader *r, struct state *s)
+{
+	return state_strtoul(r, "maxit", &s->maxit)
+		&& state_limits_read(r, &s->limits);
+}
+
+static bool loader_2(struct reader *r, struct state *s)
+{
+	if (!loader_1(r, s))
+		return false;
+
+	unsigned long num_elem;
+	if (!state_strtoul(r, "num_elem", &num_elem))
+		return false;
+
+	/* grown as entries come, the count may be anything */
+	unsigned long size = 0;
+	for (unsigned long i = 0; i < num_elem; i++) {
+		if (i == size) {
+			size = size ? 2 * size : 16;
+			s->history = xrealloc(s->history,
+					size * sizeof(*s->history));
+		}
+		if (!state_limits_read(r, &s->history[i]))
+			return false;
+		s->nhistory = i + 1;
+	}
+
+	return true;
+}
+
+static bool (*format_loaders[])(struct reader *, struct state *) = {
+	[GMANDEL_STATE_0] = NULL,
+	[GMANDEL_STATE_1] = loader_1,
+	[GMANDEL_STATE_2] = loader_2,
+	[GMANDEL_STATE_LAST] = NULL,
+};
+
+bool state_read(FILE *file, struct state *s, char *err, size_t errlen)
+{
+	struct reader r = {
+		.file = file,
+		.err = err,
+		.errlen = errlen,
+	};
+
+	s->maxit = 0;
+	s->history = NULL;
+	s->nhistory = 0;
+
+	if (!state_fgets(&r))
+		return false;
+
+	for (unsigned i = GMANDEL_STATE_CURRENT; i > GMANDEL_STATE_0; i--) {
+		if (strcmp(r.buf, format_strings[i]) != 0)
+			continue;
+		if ((*format_loaders[i])(&r, s))
+			return true;
+		state_free(s);
+		return false;
+	}
+
+	snprintf(err, errlen, "Unsupported format");
+	return false;
+}
+
+void state_write(FILE *file, const struct state *s)
+{
+	fprintf(file, "%s\n", format_strings[GMANDEL_STATE_CURRENT]);
+	fprintf(file, "%lu\n%a\n%a\n%a\n", s->maxit,
+			s->limits.ulx, s->limits.uly, s->limits.lly);
+	fprintf(file, "%lu\n", s->nhistory);
+	for (unsigned long i = 0; i < s->nhistory; i++)
+		fprintf(file, "%a\n%a\n%a\n", s->history[i].ulx,
+				s->history[i].uly, s->history[i].lly);
+}
+
+void state_free(struct state *s)
+{
+	free(s->history);
+	s->history = NULL;
+	s->nhistory = 0;
+}
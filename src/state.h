@@ -0,0 +1,64 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_STATE_H_
+#define GMANDEL_STATE_H_ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* What a gmandel-1 or gmandel-2 state file holds: maxit, the view as its
+ * limits and, since gmandel-2, the views zoomed in from before it.
+ */
+struct state_limits {
+	double ulx;
+	double uly;
+	double lly;
+};
+
+struct state {
+	unsigned long maxit;
+	struct state_limits limits;
+	/* oldest first, as they are in the file */
+	struct state_limits *history;
+	unsigned long nhistory;
+};
+
+/* Reads a state from file, starting at its format line. On failure it
+ * returns false with why in err, and s holds nothing to free.
+ */
+bool state_read(FILE *file, struct state *s, char *err, size_t errlen);
+/* Writes s in the current format */
+void state_write(FILE *file, const struct state *s);
+void state_free(struct state *s);
+
+#endif
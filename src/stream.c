@@ -0,0 +1,168 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "checkpoint.h"
+#include "fract.h"
+#include "image.h"
+#include "stream.h"
+#include "xfuncs.h"
+
+/* pixels in the render the energy average is taken from */
+#define STREAM_PREVIEW_PIXELS (1 << 20)
+
+static bool stream_energy(struct fract *f, unsigned width, unsigned height)
+{
+	double scale = sqrt((double)STREAM_PREVIEW_PIXELS / width / height);
+	if (scale < 1) {
+		width = MAX(width * scale, 2);
+		height = MAX(height * scale, 2);
+	}
+
+	fract_set_size(f, width, height);
+	fract_clean(f);
+	fract_begin(f);
+	return fract_compute(f);
+}
+
+struct stream_tick {
+	struct checkpoint *c;
+	const struct fract *f;
+};
+
+static void stream_tick(void *data)
+{
+	struct stream_tick *t = data;
+	checkpoint_tick(t->c, t->f);
+}
+
+/* Computes the band f is set up for, taking what checkpoint has of it and
+ * keeping what it does there
+ */
+static bool stream_band(struct fract *f, const char *checkpoint,
+		bool *checkpoint_failed)
+{
+	struct checkpoint c;
+	struct stream_tick t = { &c, f };
+
+	fract_clean(f);
+	if (!checkpoint) {
+		fract_begin(f);
+		return fract_compute(f);
+	}
+
+	if (!checkpoint_open(&c, checkpoint, f)) {
+		*checkpoint_failed = true;
+		return false;
+	}
+	if (c.complete) {
+		checkpoint_close(&c);
+		return true;
+	}
+
+	f->progress = stream_tick;
+	f->progress_data = &t;
+	f->tile = checkpoint_tile;
+	f->tile_data = &c;
+	fract_begin(f);
+	bool ok = fract_compute(f);
+	f->progress = NULL;
+	f->tile = NULL;
+
+	bool saved = ok ? checkpoint_finish(&c, f) : checkpoint_save(&c, f);
+	checkpoint_close(&c);
+	if (!saved) {
+		*checkpoint_failed = true;
+		return false;
+	}
+	return ok;
+}
+
+bool stream_render(struct fract *f, unsigned width, unsigned height,
+		unsigned rows, struct image *img,
+		const char *checkpoint, bool *checkpoint_failed)
+{
+	const struct fract_view view = f->view;
+	const bool equalise = f->equalise;
+	void (*progress)(void *data) = f->progress;
+	void *progress_data = f->progress_data;
+	bool ok = true;
+
+	*checkpoint_failed = false;
+
+	rows = MIN(MAX(rows, 2), height);
+
+	if (!stream_energy(f, width, height))
+		return false;
+	long double avg_v = f->avgfactor.v;
+	unsigned avg_n = f->avgfactor.n;
+
+	size_t stride = 3 * (size_t)width;
+	unsigned char *rgb = xmalloc(stride * rows);
+
+	f->equalise = false;
+	fract_set_size(f, width, rows);
+
+	for (unsigned y = 0; y < height; y += rows) {
+		/* the last band is moved up to be a whole one, and only
+		 * what the others did not cover is written from it
+		 */
+		unsigned y0 = MIN(y, height - rows);
+
+		fract_view_rows(&view, height, y0, rows, &f->view);
+		if (!stream_band(f, checkpoint, checkpoint_failed)) {
+			ok = false;
+			break;
+		}
+
+		f->avgfactor.v = avg_v;
+		f->avgfactor.n = avg_n;
+		if (!fract_colour(f, rgb, stride)) {
+			ok = false;
+			break;
+		}
+
+		if (!image_write_rows(img, rgb + (y - y0) * stride, stride,
+					rows - (y - y0))) {
+			ok = false;
+			break;
+		}
+	}
+
+	free(rgb);
+	f->view = view;
+	f->equalise = equalise;
+	f->progress = progress;
+	f->progress_data = progress_data;
+	return ok;
+}
@@ -0,0 +1,59 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_STREAM_H_
+#define GMANDEL_STREAM_H_ 1
+
+#include <stdbool.h>
+
+#include "fract.h"
+#include "image.h"
+
+/* Renders f's view at width x height into img a band of rows at a time,
+ * so that only one band's mu and colours are ever in memory however
+ * large the image. A band on its own would be coloured by its own
+ * energy average, so all of them go by that of a smaller render of the
+ * whole view, and equalised colouring is not used. f is left with the
+ * size of a band and its view as it was.
+ *
+ * checkpoint, when not NULL, is the file every band keeps its tiles in
+ * as checkpoint_open() has it, so that after a crash the bands done are
+ * only coloured again and the one cut short carries on.
+ *
+ * Returns false if f was stopped, or img or checkpoint could not be
+ * written, with errno telling why for those two. *checkpoint_failed
+ * says whether it was checkpoint.
+ */
+bool stream_render(struct fract *f, unsigned width, unsigned height,
+		unsigned rows, struct image *img,
+		const char *checkpoint, bool *checkpoint_failed);
+
+#endif
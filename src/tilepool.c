@@ -0,0 +1,254 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "tilepool.h"
+#include "xfuncs.h"
+
+struct tilepool_deque {
+	pthread_mutex_t lock;
+	unsigned *tiles;
+	unsigned head;
+	unsigned tail;
+};
+
+struct tilepool {
+	unsigned nthreads;
+	pthread_t *threads;
+	struct tilepool_deque *deques;
+	unsigned capacity;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	unsigned job;
+	unsigned busy;
+	bool quit;
+	tilepool_fn fn;
+	void *data;
+	const volatile bool *stop;
+};
+
+struct tilepool_worker {
+	struct tilepool *pool;
+	unsigned id;
+};
+
+unsigned tilepool_default_nthreads(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? n : 1;
+}
+
+static bool deque_pop(struct tilepool_deque *d, unsigned *tile)
+{
+	bool ret = false;
+	pthread_mutex_lock(&d->lock);
+	if (d->head < d->tail) {
+		*tile = d->tiles[--d->tail];
+		ret = true;
+	}
+	pthread_mutex_unlock(&d->lock);
+	return ret;
+}
+
+static bool deque_steal(struct tilepool_deque *d, unsigned *tile)
+{
+	bool ret = false;
+	pthread_mutex_lock(&d->lock);
+	if (d->head < d->tail) {
+		*tile = d->tiles[d->head++];
+		ret = true;
+	}
+	pthread_mutex_unlock(&d->lock);
+	return ret;
+}
+
+static bool next_tile(struct tilepool *p, unsigned id, unsigned *tile)
+{
+	if (deque_pop(&p->deques[id], tile))
+		return true;
+	for (unsigned i = 1; i < p->nthreads; i++)
+		if (deque_steal(&p->deques[(id + i) % p->nthreads], tile))
+			return true;
+	return false;
+}
+
+static void process(struct tilepool *p, unsigned id)
+{
+	unsigned tile;
+	while (!(p->stop && *p->stop) && next_tile(p, id, &tile))
+		(*p->fn)(p->data, tile, id);
+}
+
+static void *worker(void *data)
+{
+	struct tilepool_worker *w = data;
+	struct tilepool *p = w->pool;
+	unsigned seen = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&p->lock);
+		while (p->job == seen && !p->quit)
+			pthread_cond_wait(&p->wake, &p->lock);
+		seen = p->job;
+		bool quit = p->quit;
+		pthread_mutex_unlock(&p->lock);
+
+		if (quit)
+			break;
+
+		process(p, w->id);
+
+		pthread_mutex_lock(&p->lock);
+		if (--p->busy == 0)
+			pthread_cond_signal(&p->done);
+		pthread_mutex_unlock(&p->lock);
+	}
+
+	free(w);
+	return NULL;
+}
+
+struct tilepool *tilepool_new(unsigned nthreads)
+{
+	struct tilepool *p = xmalloc(sizeof(*p));
+
+	p->nthreads = nthreads ? nthreads : tilepool_default_nthreads();
+	p->capacity = 0;
+	p->job = 0;
+	p->busy = 0;
+	p->quit = false;
+	p->fn = NULL;
+	p->data = NULL;
+	p->stop = NULL;
+
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->wake, NULL);
+	pthread_cond_init(&p->done, NULL);
+
+	p->deques = xmalloc(p->nthreads * sizeof(*p->deques));
+	for (unsigned i = 0; i < p->nthreads; i++) {
+		pthread_mutex_init(&p->deques[i].lock, NULL);
+		p->deques[i].tiles = NULL;
+		p->deques[i].head = p->deques[i].tail = 0;
+	}
+
+	/* thread 0 is whoever calls tilepool_run() */
+	p->threads = xmalloc(p->nthreads * sizeof(*p->threads));
+	for (unsigned i = 1; i < p->nthreads; i++) {
+		struct tilepool_worker *w = xmalloc(sizeof(*w));
+		w->pool = p;
+		w->id = i;
+		if (pthread_create(&p->threads[i], NULL, worker, w) != 0)
+			oom("pthread_create failed.");
+	}
+
+	return p;
+}
+
+void tilepool_free(struct tilepool *p)
+{
+	if (!p)
+		return;
+
+	pthread_mutex_lock(&p->lock);
+	p->quit = true;
+	pthread_cond_broadcast(&p->wake);
+	pthread_mutex_unlock(&p->lock);
+
+	for (unsigned i = 1; i < p->nthreads; i++)
+		pthread_join(p->threads[i], NULL);
+
+	for (unsigned i = 0; i < p->nthreads; i++) {
+		pthread_mutex_destroy(&p->deques[i].lock);
+		free(p->deques[i].tiles);
+	}
+
+	pthread_cond_destroy(&p->done);
+	pthread_cond_destroy(&p->wake);
+	pthread_mutex_destroy(&p->lock);
+
+	free(p->deques);
+	free(p->threads);
+	free(p);
+}
+
+unsigned tilepool_get_nthreads(const struct tilepool *p)
+{
+	return p->nthreads;
+}
+
+bool tilepool_run(struct tilepool *p, unsigned ntiles,
+		tilepool_fn fn, void *data, const volatile bool *stop)
+{
+	if (ntiles > p->capacity) {
+		for (unsigned i = 0; i < p->nthreads; i++)
+			p->deques[i].tiles = xrealloc(p->deques[i].tiles,
+					ntiles * sizeof(*p->deques[i].tiles));
+		p->capacity = ntiles;
+	}
+
+	/* Neighbouring tiles tend to cost about the same, so hand out
+	 * contiguous runs and let stealing even things out.
+	 */
+	for (unsigned i = 0; i < p->nthreads; i++) {
+		struct tilepool_deque *d = &p->deques[i];
+		unsigned first = (unsigned long long)ntiles * i / p->nthreads;
+		unsigned last = (unsigned long long)ntiles * (i + 1) / p->nthreads;
+		d->head = 0;
+		d->tail = last - first;
+		for (unsigned t = first; t < last; t++)
+			d->tiles[t - first] = last - 1 - (t - first);
+	}
+
+	pthread_mutex_lock(&p->lock);
+	p->fn = fn;
+	p->data = data;
+	p->stop = stop;
+	p->busy = p->nthreads - 1;
+	p->job++;
+	pthread_cond_broadcast(&p->wake);
+	pthread_mutex_unlock(&p->lock);
+
+	process(p, 0);
+
+	pthread_mutex_lock(&p->lock);
+	while (p->busy > 0)
+		pthread_cond_wait(&p->done, &p->lock);
+	p->fn = NULL;
+	p->data = NULL;
+	p->stop = NULL;
+	pthread_mutex_unlock(&p->lock);
+
+	return !(stop && *stop);
+}
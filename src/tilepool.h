@@ -0,0 +1,59 @@
+/* vim: set sts=4 sw=4 noet : */
+
+/*
+ * Copyright (c) 2009, Fernando J. Pereda <ferdy@ferdyx.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the program nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GMANDEL_TILEPOOL_H_
+#define GMANDEL_TILEPOOL_H_ 1
+
+#include <stdbool.h>
+
+/* A pool of worker threads that process numbered tiles. Every thread owns
+ * a deque of tiles and, when it runs dry, steals from the other end of
+ * somebody else's deque.
+ */
+struct tilepool;
+
+typedef void (*tilepool_fn)(void *data, unsigned tile, unsigned thread);
+
+unsigned tilepool_default_nthreads(void);
+
+struct tilepool *tilepool_new(unsigned nthreads);
+void tilepool_free(struct tilepool *p);
+
+unsigned tilepool_get_nthreads(const struct tilepool *p);
+
+/* Calls fn once for every tile in [0, ntiles) and returns when all of
+ * them are done or *stop became true. The calling thread takes part in
+ * the work as thread 0.
+ */
+bool tilepool_run(struct tilepool *p, unsigned ntiles,
+		tilepool_fn fn, void *data, const volatile bool *stop);
+
+#endif
@@ -50,6 +50,16 @@
 #    define unlikely(a) (a)
 #endif
 
+#define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
+
+/* glib has its own, which is the same */
+#ifndef MIN
+#    define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#    define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
 static GMANDEL_ATTRIBUTE(noreturn) void oom(const char *s)
 {
 	fprintf(stderr, "Oom. %s\n", s);
@@ -72,6 +82,14 @@ static inline void *xrealloc(void *p, size_t s)
 	return ret;
 }
 
+static inline void *xmalloc_aligned(size_t align, size_t s)
+{
+	void *p;
+	if (unlikely(posix_memalign(&p, align, s ? s : 1) != 0))
+		oom("posix_memalign failed.");
+	return p;
+}
+
 static inline char *xstrdup(const char *c)
 {
 	char *p = strdup(c);